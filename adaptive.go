@@ -0,0 +1,158 @@
+package franken_zstd
+
+//#include <zend.h>
+import "C"
+import (
+	"fmt"
+	"math"
+	"sync/atomic"
+	"time"
+	"unsafe"
+)
+
+// An adaptive compressor picks its level per input instead of using a fixed
+// one: the strongest level whose measured encode throughput meets a target.
+// Inputs are split in size classes, since small payloads compress at a
+// fraction of the throughput of large ones, and each class moves between
+// the four levels klauspost encodes differently. Timings are wall-clock, so
+// when threads contend for CPU every level measures slower and the classes
+// back off to faster levels on their own.
+var (
+	// LEVEL_FASTEST, LEVEL_DEFAULT, LEVEL_BETTER and LEVEL_ULTRA, one per
+	// klauspost encoder level
+	adaptiveLevels = [...]int{1, 3, 6, 19}
+
+	// Smallest input of each size class
+	adaptiveClassSizes = [...]int{0, 4 << 10, 64 << 10, 1 << 20}
+)
+
+const (
+	// Weight of the newest timing in the throughput average of a level
+	adaptiveSmoothing = 0.2
+
+	// A class tries the next stronger level every this many encodes, while
+	// its current level runs at adaptiveHeadroom times the target or more
+	adaptiveProbeInterval = 64
+	adaptiveHeadroom      = 2
+)
+
+type adaptiveClass struct {
+	level      atomic.Int32 // Index into adaptiveLevels
+	operations atomic.Int64
+	// Average throughput of each level in bytes per second, as float64
+	// bits; 0 until measured
+	throughput [len(adaptiveLevels)]atomic.Uint64
+}
+
+type adaptiveController struct {
+	target  float64 // Minimum throughput in bytes per second
+	classes [len(adaptiveClassSizes)]adaptiveClass
+}
+
+// newAdaptiveController targets a minimum throughput in MB/s. Every class
+// starts at LEVEL_DEFAULT.
+func newAdaptiveController(targetThroughput float64) (*adaptiveController, error) {
+	if !(targetThroughput > 0) || math.IsInf(targetThroughput, 1) {
+		return nil, fmt.Errorf("invalid target throughput: %g (must be more than 0 MB/s)", targetThroughput)
+	}
+
+	a := &adaptiveController{target: targetThroughput * (1 << 20)}
+	for i := range a.classes {
+		a.classes[i].level.Store(1)
+	}
+	return a, nil
+}
+
+func (a *adaptiveController) class(size int) *adaptiveClass {
+	i := len(adaptiveClassSizes) - 1
+	for size < adaptiveClassSizes[i] {
+		i--
+	}
+	return &a.classes[i]
+}
+
+// level returns the index of the level to compress size bytes with
+func (a *adaptiveController) level(size int) int {
+	return int(a.class(size).level.Load())
+}
+
+// observe records an encode of size bytes at a level index and moves the
+// size class to a faster level when the level falls short of the target, or
+// periodically to a stronger one when it has headroom
+func (a *adaptiveController) observe(size, level int, elapsed time.Duration) {
+	class := a.class(size)
+	average := class.record(level, float64(size)/max(elapsed, time.Nanosecond).Seconds())
+
+	// Only the level in use moves the class, so an encode that started
+	// before a concurrent move does not move it twice
+	switch {
+	case average < a.target:
+		if level > 0 {
+			class.level.CompareAndSwap(int32(level), int32(level-1))
+		}
+	case level+1 < len(adaptiveLevels) && average >= a.target*adaptiveHeadroom:
+		if class.operations.Add(1)%adaptiveProbeInterval == 0 {
+			class.level.CompareAndSwap(int32(level), int32(level+1))
+		}
+	}
+}
+
+// record adds a throughput sample to the average of a level and returns
+// the new average
+func (c *adaptiveClass) record(level int, sample float64) float64 {
+	for {
+		bits := c.throughput[level].Load()
+		average := sample
+		if bits != 0 {
+			average += (math.Float64frombits(bits) - sample) * (1 - adaptiveSmoothing)
+		}
+		if c.throughput[level].CompareAndSwap(bits, math.Float64bits(average)) {
+			return average
+		}
+	}
+}
+
+// export reports the target in MB/s and, per size class, its smallest
+// input, current level and the average throughput of that level in MB/s
+func (a *adaptiveController) export(target *float64, minSizes, levels []int64, throughput []float64) {
+	*target = a.target / (1 << 20)
+	for i := range a.classes {
+		level := a.classes[i].level.Load()
+		minSizes[i] = int64(adaptiveClassSizes[i])
+		levels[i] = int64(adaptiveLevels[level])
+		throughput[i] = math.Float64frombits(a.classes[i].throughput[level].Load()) / (1 << 20)
+	}
+}
+
+//export go_compressor_create_adaptive
+func go_compressor_create_adaptive(targetThroughput float64, windowSize, dictID, threads int64, handle *C.uint64_t) *C.char {
+	compressor, err := NewAdaptiveCompressor(targetThroughput, int(windowSize), uint32(dictID), int(threads))
+	if err != nil {
+		return C.CString(err.Error())
+	}
+
+	h, err := compressorRegistry.register(compressor)
+	if err != nil {
+		compressor.Close()
+		return C.CString(err.Error())
+	}
+
+	*handle = C.uint64_t(h)
+	return nil // Success
+}
+
+// Adaptive state of a compressor, for getStats(). The arrays hold
+// FRANKEN_ZSTD_ADAPTIVE_CLASSES entries. Returns false for a fixed level
+// compressor.
+//
+//export go_compressor_get_adaptive
+func go_compressor_get_adaptive(handle C.uint64_t, target *float64, minSizes, levels *int64, throughput *float64) bool {
+	compressor, err := compressorRegistry.lookup(uint64(handle))
+	if err != nil || compressor.adaptive == nil {
+		return false
+	}
+
+	classes := len(adaptiveClassSizes)
+	compressor.adaptive.export(target, unsafe.Slice(minSizes, classes), unsafe.Slice(levels, classes), unsafe.Slice(throughput, classes))
+	return true
+}
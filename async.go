@@ -0,0 +1,133 @@
+package franken_zstd
+
+//#include <zend.h>
+import "C"
+import (
+	"errors"
+	"fmt"
+	"time"
+)
+
+// Future is a compression or decompression running on its own goroutine
+// while the PHP thread carries on. The C side keeps the input and the
+// preallocated output alive until the future is collected, so the goroutine
+// reads and writes them in place, as a synchronous call would.
+type Future struct {
+	done   chan struct{}
+	buf    []byte
+	result []byte
+	err    error
+}
+
+var futureRegistry = handleRegistry[Future]{notFound: errors.New("future not found")}
+
+// startFuture runs work on a new goroutine, appending to buf, and returns
+// the handle collecting its result
+func startFuture(buf []byte, work func(dst []byte) ([]byte, error)) (uint64, error) {
+	f := &Future{done: make(chan struct{}), buf: buf}
+	handle, err := futureRegistry.register(f)
+	if err != nil {
+		return 0, err
+	}
+
+	go func() {
+		defer close(f.done)
+		f.result, f.err = work(buf)
+	}()
+	return handle, nil
+}
+
+// Asynchronous compression with the pooled encoders of a level. Settings are
+// checked up front, so only the compression itself can fail later.
+//
+//export go_compress_async
+func go_compress_async(data *C.zend_string, level, dictID int64, result *C.zend_string, handle *C.uint64_t) *C.char {
+	if level < 1 || level > 22 {
+		return C.CString(fmt.Sprintf("invalid compression level: %d (must be 1-22)", level))
+	}
+	if dictID != 0 {
+		if _, err := lookupDictionary(uint32(dictID)); err != nil {
+			return C.CString(err.Error())
+		}
+	}
+
+	input := zendStringBytes(data)
+	h, err := startFuture(zendStringBuffer(result), func(dst []byte) ([]byte, error) {
+		startTime := time.Now()
+		compressed, err := quickCompress(input, dst, int(level), uint32(dictID))
+		recordCompress(int(level), len(input), len(compressed), time.Since(startTime), err)
+		return compressed, err
+	})
+	if err != nil {
+		return C.CString(err.Error())
+	}
+
+	*handle = C.uint64_t(h)
+	return nil // Success
+}
+
+// Asynchronous decompression with the pooled decoders
+//
+//export go_decompress_async
+func go_decompress_async(data *C.zend_string, maxOutput int64, result *C.zend_string, handle *C.uint64_t) *C.char {
+	input := zendStringBytes(data)
+	h, err := startFuture(zendStringBuffer(result), func(dst []byte) ([]byte, error) {
+		startTime := time.Now()
+		decompressed, err := decompressWithin(input, dst, maxOutput, quickDecompress)
+		recordDecompress(len(input), len(decompressed), time.Since(startTime), err)
+		return decompressed, err
+	})
+	if err != nil {
+		return C.CString(err.Error())
+	}
+
+	*handle = C.uint64_t(h)
+	return nil // Success
+}
+
+//export go_future_ready
+func go_future_ready(handle C.uint64_t) bool {
+	f, err := futureRegistry.lookup(uint64(handle))
+	if err != nil {
+		return true // Already collected
+	}
+
+	select {
+	case <-f.done:
+		return true
+	default:
+		return false
+	}
+}
+
+// Blocks until the future completes and reports its result as a synchronous
+// call would. The handle is released.
+//
+//export go_future_wait
+func go_future_wait(handle C.uint64_t, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	f, err := futureRegistry.unregister(uint64(handle))
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	<-f.done
+	if f.err != nil {
+		*error = C.CString(f.err.Error())
+		return
+	}
+
+	storeResult(f.buf, f.result, resultLen, pending)
+}
+
+// Waits for a future nobody collected, so the C side can free its input and
+// output, and drops its result
+//
+//export go_future_discard
+func go_future_discard(handle C.uint64_t) {
+	f, err := futureRegistry.unregister(uint64(handle))
+	if err != nil {
+		return
+	}
+	<-f.done
+}
@@ -0,0 +1,195 @@
+package franken_zstd
+
+//#include <zend.h>
+import "C"
+import (
+	"fmt"
+	"runtime"
+	"sync"
+	"sync/atomic"
+	"time"
+	"unsafe"
+)
+
+// batchResults gives access to the per-item arrays the C side allocates for a
+// batch: the input strings, the preallocated output strings and the slots Go
+// reports each output or error in. Every worker only touches its own index.
+type batchResults struct {
+	items      []*C.zend_string
+	outputs    []*C.zend_string
+	resultLens []C.size_t
+	pending    []C.uintptr_t
+	errors     []*C.char
+}
+
+func newBatchResults(items, outputs **C.zend_string, count C.size_t, resultLens *C.size_t, pending *C.uintptr_t, errors **C.char) *batchResults {
+	n := int(count)
+	return &batchResults{
+		items:      unsafe.Slice(items, n),
+		outputs:    unsafe.Slice(outputs, n),
+		resultLens: unsafe.Slice(resultLens, n),
+		pending:    unsafe.Slice(pending, n),
+		errors:     unsafe.Slice(errors, n),
+	}
+}
+
+// run applies process to every item on a bounded pool of goroutines and
+// returns the total input and output sizes. Errors are reported per item and
+// never stop the rest of the batch. Each item is passed to record for the
+// metrics.
+func (b *batchResults) run(process func(data, dst []byte) ([]byte, error), record func(in, out int, elapsed time.Duration, err error)) (inputSize, outputSize int64) {
+	var inputTotal, outputTotal atomic.Int64
+	parallelEach(len(b.items), func(i int) {
+		data := zendStringBytes(b.items[i])
+		buf := zendStringBuffer(b.outputs[i])
+		startTime := time.Now()
+		out, err := process(data, buf)
+		record(len(data), len(out), time.Since(startTime), err)
+		if err != nil {
+			b.errors[i] = C.CString(err.Error())
+			return
+		}
+		inputTotal.Add(int64(len(data)))
+		outputTotal.Add(int64(len(out)))
+		storeResult(buf, out, &b.resultLens[i], &b.pending[i])
+	})
+	return inputTotal.Load(), outputTotal.Load()
+}
+
+// parallelWorkers returns the number of goroutines parallelEach spreads
+// count items over
+func parallelWorkers(count int) int {
+	return max(min(count, runtime.GOMAXPROCS(0)), 1)
+}
+
+// parallelEach calls fn for every index below count, spread over at most
+// GOMAXPROCS goroutines. Items are handed out one at a time, so a few large
+// items do not leave the other workers idle.
+func parallelEach(count int, fn func(i int)) {
+	workers := parallelWorkers(count)
+	if workers <= 1 {
+		for i := 0; i < count; i++ {
+			fn(i)
+		}
+		return
+	}
+
+	var next atomic.Int64
+	var wg sync.WaitGroup
+	wg.Add(workers)
+	for w := 0; w < workers; w++ {
+		go func() {
+			defer wg.Done()
+			for {
+				i := int(next.Add(1) - 1)
+				if i >= count {
+					return
+				}
+				fn(i)
+			}
+		}()
+	}
+	wg.Wait()
+}
+
+// compressMany compresses every item with the compressor's encoder, which
+// accepts concurrent EncodeAll calls. The stats describe the whole batch.
+// Items are recorded as they are encoded, since an adaptive compressor may
+// use a different level for each.
+func (c *Compressor) compressMany(b *batchResults) error {
+	workers := parallelWorkers(len(b.items))
+	codecs, err := c.acquire(workers)
+	if err != nil {
+		return err
+	}
+	defer c.done(workers)
+
+	startTime := time.Now()
+	originalSize, compressedSize := b.run(func(data, dst []byte) ([]byte, error) {
+		itemStart := time.Now()
+		compressed, level := c.encode(codecs, data, dst)
+		c.recordCompress(level, len(data), len(compressed)-len(dst), time.Since(itemStart), nil)
+		return compressed, nil
+	}, func(int, int, time.Duration, error) {})
+
+	c.setStats(originalSize, compressedSize, time.Since(startTime))
+	return nil
+}
+
+// decompressMany decompresses every item with the compressor's decoder, which
+// accepts concurrent DecodeAll calls, routing frames compressed with another
+// registered dictionary to it. Each output is limited to maxOutput bytes (0
+// for no limit).
+func (c *Compressor) decompressMany(b *batchResults, maxOutput int64) error {
+	workers := parallelWorkers(len(b.items))
+	codecs, err := c.acquire(workers)
+	if err != nil {
+		return err
+	}
+	defer c.done(workers)
+
+	decode := func(data, dst []byte) ([]byte, error) {
+		return c.decompress(codecs.decoder, data, dst)
+	}
+	b.run(func(data, dst []byte) ([]byte, error) {
+		return decompressWithin(data, dst, maxOutput, decode)
+	}, c.recordDecompress)
+	return nil
+}
+
+//export go_compressor_compress_many
+func go_compressor_compress_many(handle C.uint64_t, items, outputs **C.zend_string, count C.size_t, resultLens *C.size_t, pending *C.uintptr_t, errors **C.char) *C.char {
+	compressor, err := compressorRegistry.lookup(uint64(handle))
+	if err != nil {
+		return C.CString(err.Error())
+	}
+
+	if err := compressor.compressMany(newBatchResults(items, outputs, count, resultLens, pending, errors)); err != nil {
+		return C.CString(err.Error())
+	}
+	return nil // Success
+}
+
+//export go_compressor_decompress_many
+func go_compressor_decompress_many(handle C.uint64_t, items, outputs **C.zend_string, count C.size_t, maxOutput int64, resultLens *C.size_t, pending *C.uintptr_t, errors **C.char) *C.char {
+	compressor, err := compressorRegistry.lookup(uint64(handle))
+	if err != nil {
+		return C.CString(err.Error())
+	}
+
+	if err := compressor.decompressMany(newBatchResults(items, outputs, count, resultLens, pending, errors), maxOutput); err != nil {
+		return C.CString(err.Error())
+	}
+	return nil // Success
+}
+
+// Quick batch compression with the pooled encoders of a level
+//
+//export go_quick_compress_many
+func go_quick_compress_many(items, outputs **C.zend_string, count C.size_t, level, dictID int64, resultLens *C.size_t, pending *C.uintptr_t, errors **C.char) *C.char {
+	// Settings errors concern the whole batch, so report them once
+	if level < 1 || level > 22 {
+		return C.CString(fmt.Sprintf("invalid compression level: %d (must be 1-22)", level))
+	}
+	if dictID != 0 {
+		if _, err := lookupDictionary(uint32(dictID)); err != nil {
+			return C.CString(err.Error())
+		}
+	}
+
+	newBatchResults(items, outputs, count, resultLens, pending, errors).run(func(data, dst []byte) ([]byte, error) {
+		return quickCompress(data, dst, int(level), uint32(dictID))
+	}, func(in, out int, elapsed time.Duration, err error) {
+		recordCompress(int(level), in, out, elapsed, err)
+	})
+	return nil // Success
+}
+
+// Quick batch decompression with the pooled decoders
+//
+//export go_quick_decompress_many
+func go_quick_decompress_many(items, outputs **C.zend_string, count C.size_t, maxOutput int64, resultLens *C.size_t, pending *C.uintptr_t, errors **C.char) {
+	newBatchResults(items, outputs, count, resultLens, pending, errors).run(func(data, dst []byte) ([]byte, error) {
+		return decompressWithin(data, dst, maxOutput, quickDecompress)
+	}, recordDecompress)
+}
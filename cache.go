@@ -0,0 +1,161 @@
+package franken_zstd
+
+//#include <zend.h>
+import "C"
+import (
+	"bytes"
+	"container/list"
+	"crypto/rand"
+	"encoding/binary"
+	"sync"
+	"sync/atomic"
+
+	"github.com/cespare/xxhash/v2"
+)
+
+// Process-wide cache of compressed results, shared by every thread. Inputs
+// compressed again with the same settings, such as popular pages or config
+// blobs, cost a hash and a copy instead of an encode. Entries are found by
+// an xxhash of the input, seeded per process so that colliding inputs cannot
+// be crafted offline, and evicted least recently used first once their
+// compressed bytes exceed the capacity. Disabled while the capacity is 0.
+const (
+	// Smaller inputs compress faster than the cache bookkeeping pays off
+	cacheMinInputSize = 1 << 10
+
+	// Estimate of the map, list and key memory of an entry
+	cacheEntryOverhead = 128
+)
+
+// cacheKey identifies a compression: the input and every setting that
+// changes the output
+type cacheKey struct {
+	hash       uint64
+	length     int
+	level      int
+	windowSize int // 0 for the pooled encoders of the quick functions
+	dictID     uint32
+}
+
+type cacheEntry struct {
+	key        cacheKey
+	compressed []byte
+}
+
+var resultCache = struct {
+	capacity atomic.Int64
+	hits     atomic.Int64
+	misses   atomic.Int64
+
+	mu      sync.Mutex
+	entries map[cacheKey]*list.Element
+	order   list.List // Most recently used first
+	size    int64
+}{entries: make(map[cacheKey]*list.Element)}
+
+var cacheSeed = func() uint64 {
+	var seed [8]byte
+	rand.Read(seed[:])
+	return binary.LittleEndian.Uint64(seed[:])
+}()
+
+// resizeCache sets the capacity of the cache in bytes, evicting entries
+// past it; 0 disables and empties the cache
+func resizeCache(capacity int64) {
+	resultCache.mu.Lock()
+	defer resultCache.mu.Unlock()
+
+	resultCache.capacity.Store(capacity)
+	evictCache(capacity)
+}
+
+// evictCache drops the least recently used entries until the cache fits in
+// capacity. The caller holds the cache lock.
+func evictCache(capacity int64) {
+	for resultCache.size > capacity {
+		entry := resultCache.order.Remove(resultCache.order.Back()).(*cacheEntry)
+		delete(resultCache.entries, entry.key)
+		resultCache.size -= int64(len(entry.compressed)) + cacheEntryOverhead
+	}
+}
+
+// cachedCompress appends the compressed form of data to dst, taken from the
+// cache when the same input was compressed with the same settings, and
+// otherwise produced by encode and cached
+func cachedCompress(data, dst []byte, key cacheKey, encode func(data, dst []byte) []byte) []byte {
+	if resultCache.capacity.Load() == 0 || len(data) < cacheMinInputSize {
+		return encode(data, dst)
+	}
+
+	var digest xxhash.Digest
+	digest.ResetWithSeed(cacheSeed)
+	digest.Write(data)
+	key.hash = digest.Sum64()
+	key.length = len(data)
+
+	if compressed, ok := cacheGet(key); ok {
+		resultCache.hits.Add(1)
+		return append(dst, compressed...)
+	}
+
+	resultCache.misses.Add(1)
+	out := encode(data, dst)
+	cachePut(key, out[len(dst):])
+	return out
+}
+
+func cacheGet(key cacheKey) ([]byte, bool) {
+	resultCache.mu.Lock()
+	defer resultCache.mu.Unlock()
+
+	element, ok := resultCache.entries[key]
+	if !ok {
+		return nil, false
+	}
+	resultCache.order.MoveToFront(element)
+	// Entries are never modified, so the bytes stay valid once unlocked
+	return element.Value.(*cacheEntry).compressed, true
+}
+
+// cachePut caches a compressed result. Results larger than a quarter of the
+// capacity are left out, so one payload cannot flush the whole cache.
+func cachePut(key cacheKey, compressed []byte) {
+	capacity := resultCache.capacity.Load()
+	size := int64(len(compressed)) + cacheEntryOverhead
+	if size > capacity/4 {
+		return
+	}
+	entry := &cacheEntry{key: key, compressed: bytes.Clone(compressed)}
+
+	resultCache.mu.Lock()
+	defer resultCache.mu.Unlock()
+
+	if element, ok := resultCache.entries[key]; ok {
+		// Compressed meanwhile by another thread
+		resultCache.order.MoveToFront(element)
+		return
+	}
+	resultCache.entries[key] = resultCache.order.PushFront(entry)
+	resultCache.size += size
+	evictCache(resultCache.capacity.Load())
+}
+
+// cacheUsage returns the number of cached entries and their estimated size
+func cacheUsage() (entries int, size int64) {
+	resultCache.mu.Lock()
+	defer resultCache.mu.Unlock()
+
+	return len(resultCache.entries), resultCache.size
+}
+
+// Current cache counters, for getCacheStats()
+//
+//export go_get_cache_stats
+func go_get_cache_stats(hits, misses, entries, size, capacity *int64) {
+	*hits = resultCache.hits.Load()
+	*misses = resultCache.misses.Load()
+	count, used := cacheUsage()
+	*entries = int64(count)
+	*size = used
+	*capacity = resultCache.capacity.Load()
+}
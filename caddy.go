@@ -4,22 +4,53 @@ package franken_zstd
 import "C"
 import (
 	"context"
+	"errors"
+	"fmt"
+	"math"
+	"strconv"
+	"strings"
+	"time"
 	"unsafe"
 
 	"github.com/caddyserver/caddy/v2"
+	"github.com/caddyserver/caddy/v2/caddyconfig"
 	"github.com/caddyserver/caddy/v2/caddyconfig/caddyfile"
+	"github.com/caddyserver/caddy/v2/caddyconfig/httpcaddyfile"
 	"github.com/dunglas/frankenphp"
+	"github.com/prometheus/client_golang/prometheus"
 	"go.uber.org/zap"
 )
 
 func init() {
 	caddy.RegisterModule(App{})
+	httpcaddyfile.RegisterGlobalOption("zstd", parseGlobalOption)
 	frankenphp.RegisterExtension(unsafe.Pointer(&C.zstd_module_entry))
 }
 
 // App is the Caddy app for the zstd extension
 type App struct {
+	// Number of encoders to preallocate per encoder level at startup and
+	// keep warm for the quick functions, whatever the garbage collector does
+	WarmEncoders int `json:"warm_encoders,omitempty"`
+
+	// Upper bound, in bytes, of the memory held by compressor encoders and
+	// decoders; 0 for none
+	MemoryBudget int64 `json:"memory_budget,omitempty"`
+
+	// Compressors unused for this long release their encoder and decoder
+	// until next used; 0 to keep them
+	IdleTimeout caddy.Duration `json:"idle_timeout,omitempty"`
+
+	// Cap, in bytes, on the window and in-memory output of decoders; 0 for
+	// the library default
+	DecoderMaxMemory int64 `json:"decoder_max_memory,omitempty"`
+
+	// Capacity, in bytes, of the process-wide cache of compressed results;
+	// 0 to disable it
+	CacheSize int64 `json:"cache_size,omitempty"`
+
 	logger *zap.Logger
+	stop   chan struct{}
 }
 
 // CaddyModule returns the Caddy module information
@@ -30,29 +61,143 @@ func (App) CaddyModule() caddy.ModuleInfo {
 	}
 }
 
-// Provision sets up the app
+// Provision sets up the app and exposes the process-wide metrics on Caddy's
+// metrics endpoint
 func (a *App) Provision(ctx caddy.Context) error {
 	a.logger = ctx.Logger()
+
+	// The registry belongs to this config, so a reload registers into a new
+	// one. A collector already registered with it comes from another zstd
+	// app of the same config and exposes the same process-wide metrics.
+	err := ctx.GetMetricsRegistry().Register(newMetricsCollector())
+	if err != nil && !errors.As(err, new(prometheus.AlreadyRegisteredError)) {
+		return fmt.Errorf("registering zstd metrics: %w", err)
+	}
+
 	return nil
 }
 
 // Start starts the app
 func (a *App) Start() error {
-	a.logger.Info("zstd extension started")
+	if a.WarmEncoders > 0 {
+		WarmEncoderPools(a.WarmEncoders)
+	}
+
+	memoryBudget.Store(a.MemoryBudget)
+	decoderMaxMemory.Store(a.DecoderMaxMemory)
+	resizeCache(a.CacheSize)
+	if a.IdleTimeout > 0 {
+		a.stop = make(chan struct{})
+		startIdleEviction(time.Duration(a.IdleTimeout), a.stop)
+	}
+
+	a.logger.Info("zstd extension started",
+		zap.Int("warm_encoders", a.WarmEncoders),
+		zap.Int64("memory_budget", a.MemoryBudget),
+		zap.Duration("idle_timeout", time.Duration(a.IdleTimeout)),
+		zap.Int64("decoder_max_memory", a.DecoderMaxMemory),
+		zap.Int64("cache_size", a.CacheSize))
 	return nil
 }
 
 // Stop stops the app
 func (a *App) Stop() error {
+	if a.stop != nil {
+		close(a.stop)
+	}
 	a.logger.Info("zstd extension stopped")
 	return nil
 }
 
 // UnmarshalCaddyfile implements caddyfile.Unmarshaler
+//
+//	zstd {
+//	    warm_encoders <count>
+//	    memory_budget <size>
+//	    idle_timeout <duration>
+//	    decoder_max_memory <size>
+//	    cache_size <size>
+//	}
 func (a *App) UnmarshalCaddyfile(d *caddyfile.Dispenser) error {
+	for d.Next() {
+		for d.NextBlock(0) {
+			switch d.Val() {
+			case "warm_encoders":
+				if !d.NextArg() {
+					return d.ArgErr()
+				}
+				count, err := strconv.Atoi(d.Val())
+				if err != nil || count < 0 {
+					return d.Errf("invalid warm_encoders value: %s", d.Val())
+				}
+				a.WarmEncoders = count
+			case "memory_budget", "decoder_max_memory", "cache_size":
+				option := d.Val()
+				if !d.NextArg() {
+					return d.ArgErr()
+				}
+				size, err := parseSize(d.Val())
+				if err != nil || (option == "decoder_max_memory" && size < 1<<10) {
+					return d.Errf("invalid %s value: %s", option, d.Val())
+				}
+				switch option {
+				case "memory_budget":
+					a.MemoryBudget = size
+				case "decoder_max_memory":
+					a.DecoderMaxMemory = size
+				default:
+					a.CacheSize = size
+				}
+			case "idle_timeout":
+				if !d.NextArg() {
+					return d.ArgErr()
+				}
+				timeout, err := caddy.ParseDuration(d.Val())
+				if err != nil || timeout < 0 {
+					return d.Errf("invalid idle_timeout value: %s", d.Val())
+				}
+				a.IdleTimeout = caddy.Duration(timeout)
+			default:
+				return d.Errf("unknown zstd option: %s", d.Val())
+			}
+		}
+	}
 	return nil
 }
 
+// parseSize parses a byte count with an optional KB, MB or GB suffix, in
+// powers of 1024
+func parseSize(value string) (int64, error) {
+	multiplier := int64(1)
+	upper := strings.ToUpper(value)
+	for suffix, m := range map[string]int64{"KB": 1 << 10, "MB": 1 << 20, "GB": 1 << 30} {
+		if strings.HasSuffix(upper, suffix) {
+			multiplier = m
+			value = value[:len(value)-len(suffix)]
+			break
+		}
+	}
+
+	n, err := strconv.ParseInt(value, 10, 64)
+	if err != nil || n < 0 || n > math.MaxInt64/multiplier {
+		return 0, fmt.Errorf("invalid size: %s", value)
+	}
+	return n * multiplier, nil
+}
+
+// parseGlobalOption parses the zstd global option of a Caddyfile
+func parseGlobalOption(d *caddyfile.Dispenser, _ interface{}) (interface{}, error) {
+	app := &App{}
+	if err := app.UnmarshalCaddyfile(d); err != nil {
+		return nil, err
+	}
+
+	return httpcaddyfile.App{
+		Name:  "zstd",
+		Value: caddyconfig.JSON(app, nil),
+	}, nil
+}
+
 // getContext returns the current context
 func getContext() context.Context {
 	return context.Background()
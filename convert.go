@@ -6,46 +6,31 @@ import (
 	"unsafe"
 )
 
-// zendStringToGoString converts a zend_string to a Go string
-func zendStringToGoString(zendStr *C.zend_string) string {
-	if zendStr == nil {
-		return ""
-	}
-	return C.GoStringN((*C.char)(unsafe.Pointer(&zendStr.val)), C.int(zendStr.len))
-}
-
-// zendStringToGoBytes converts a zend_string to a Go byte slice
-func zendStringToGoBytes(zendStr *C.zend_string) []byte {
-	if zendStr == nil {
+// zendStringBytes returns a slice that aliases the zend_string's bytes in place.
+// The slice is only valid for the duration of the call that received the
+// zend_string and must neither be retained nor written to.
+func zendStringBytes(zendStr *C.zend_string) []byte {
+	if zendStr == nil || zendStr.len == 0 {
 		return nil
 	}
-	return C.GoBytes(unsafe.Pointer(&zendStr.val), C.int(zendStr.len))
+	return unsafe.Slice((*byte)(unsafe.Pointer(&zendStr.val)), int(zendStr.len))
 }
 
-// goStringToZendString converts a Go string to a zend_string
-// Note: The caller is responsible for freeing the returned zend_string
-func goStringToZendString(str string) *C.zend_string {
-	if str == "" {
+// zendStringBuffer returns an empty slice backed by a zend_string allocated by
+// the C side, with its length as capacity, so Go can append output directly
+// into PHP memory
+func zendStringBuffer(zendStr *C.zend_string) []byte {
+	if zendStr == nil || zendStr.len == 0 {
 		return nil
 	}
-	cStr := C.CString(str)
-	defer C.free(unsafe.Pointer(cStr))
-
-	// Create a new zend_string with the content
-	return C.zend_string_init(cStr, C.size_t(len(str)), C._Bool(false))
+	return unsafe.Slice((*byte)(unsafe.Pointer(&zendStr.val)), int(zendStr.len))[:0]
 }
 
-// goBytesToZendString converts a Go byte slice to a zend_string
-// Note: The caller is responsible for freeing the returned zend_string
-func goBytesToZendString(data []byte) *C.zend_string {
-	if len(data) == 0 {
+// cBytes returns a slice aliasing a C buffer in place. Like zendStringBytes,
+// it is only valid for the duration of the call that received the buffer.
+func cBytes(data *C.char, length C.size_t) []byte {
+	if data == nil || length == 0 {
 		return nil
 	}
-
-	// Create a new zend_string with the binary data
-	return C.zend_string_init((*C.char)(unsafe.Pointer(&data[0])), C.size_t(len(data)), C._Bool(false))
+	return unsafe.Slice((*byte)(unsafe.Pointer(data)), int(length))
 }
-
-// External C functions that we need to declare
-//extern zend_string *zend_string_init(const char *str, size_t len, int persistent);
-//extern void free(void *ptr);
@@ -0,0 +1,98 @@
+package franken_zstd
+
+//#include <zend.h>
+import "C"
+import (
+	"fmt"
+	"math/bits"
+	"time"
+
+	"github.com/klauspost/compress/zstd"
+)
+
+// Delta compression works as zstd --patch-from: the reference is loaded as
+// raw dictionary content, so the parts of the new version it shares are
+// encoded as matches into it. The window is sized to cover the reference
+// and the new version together, so matches reach back to the start of the
+// reference. Patches carry no dictionary ID, like those of the zstd CLI, and
+// an empty reference makes a plain frame.
+const (
+	deltaMinWindowSize = 10
+	// Larger references only contribute their last 128MB, which keeps the
+	// window within the default limit of zstd decoders, the CLI included
+	deltaMaxWindowSize = 27
+)
+
+// deltaWindowSize returns the smallest window covering reference and data
+func deltaWindowSize(referenceLen, dataLen int) int {
+	return min(max(bits.Len(uint(referenceLen+dataLen)), deltaMinWindowSize), deltaMaxWindowSize)
+}
+
+// CompressDelta compresses data against reference, appending to dst
+func CompressDelta(reference, data, dst []byte, level int) ([]byte, error) {
+	if level < 1 || level > 22 {
+		return nil, fmt.Errorf("invalid compression level: %d (must be 1-22)", level)
+	}
+
+	encoderOptions, _, err := codecOptions(level, deltaWindowSize(len(reference), len(data)), 0)
+	if err != nil {
+		return nil, err
+	}
+	encoderOptions = append(encoderOptions, zstd.WithEncoderConcurrency(1))
+	if len(reference) > 0 {
+		encoderOptions = append(encoderOptions, zstd.WithEncoderDictRaw(0, reference))
+	}
+	encoder, err := zstd.NewWriter(nil, encoderOptions...)
+	if err != nil {
+		return nil, fmt.Errorf("failed to create encoder: %w", err)
+	}
+	defer encoder.Close()
+
+	return encoder.EncodeAll(data, dst), nil
+}
+
+// DecompressDelta decompresses a patch made by CompressDelta against the
+// same reference, appending to dst
+func DecompressDelta(reference, patch, dst []byte) ([]byte, error) {
+	decoderOptions := append(decoderLimits(), zstd.WithDecoderConcurrency(1))
+	if len(reference) > 0 {
+		decoderOptions = append(decoderOptions, zstd.WithDecoderDictRaw(0, reference))
+	}
+	decoder, err := zstd.NewReader(nil, decoderOptions...)
+	if err != nil {
+		return nil, fmt.Errorf("failed to create decoder: %w", err)
+	}
+	defer decoder.Close()
+
+	return decoder.DecodeAll(patch, dst)
+}
+
+//export go_compress_delta
+func go_compress_delta(reference, data *C.zend_string, level int64, result *C.zend_string, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	buf := zendStringBuffer(result)
+	input := zendStringBytes(data)
+	startTime := time.Now()
+	compressed, err := CompressDelta(zendStringBytes(reference), input, buf, int(level))
+	recordCompress(int(level), len(input), len(compressed), time.Since(startTime), err)
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	storeResult(buf, compressed, resultLen, pending)
+}
+
+//export go_decompress_delta
+func go_decompress_delta(reference, patch *C.zend_string, result *C.zend_string, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	buf := zendStringBuffer(result)
+	input := zendStringBytes(patch)
+	startTime := time.Now()
+	decompressed, err := DecompressDelta(zendStringBytes(reference), input, buf)
+	recordDecompress(len(input), len(decompressed), time.Since(startTime), err)
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	storeResult(buf, decompressed, resultLen, pending)
+}
@@ -0,0 +1,164 @@
+package franken_zstd
+
+import (
+	"bytes"
+	"errors"
+	"fmt"
+	"hash/crc32"
+	"sync"
+
+	"github.com/klauspost/compress/zstd"
+)
+
+// Upper bound of a trained dictionary
+const maxDictionarySize = 1 << 20
+
+// Process-wide dictionary cache shared by all FrankenPHP threads. Dictionaries
+// are loaded once and live for the lifetime of the process; lookups are
+// lock-free and only registration is serialized.
+var (
+	dictionaryCache   sync.Map // uint32 -> *Dictionary
+	dictionaryCacheMu sync.Mutex
+)
+
+// Dictionary is a registered zstd dictionary with its own encoder and decoder
+// pools, since klauspost encoders and decoders bind dictionaries at creation
+type Dictionary struct {
+	id       uint32
+	raw      []byte
+	encoders [zstd.SpeedBestCompression + 1]sync.Pool
+	decoders sync.Pool
+}
+
+func newDictionary(raw []byte) (*Dictionary, error) {
+	info, err := zstd.InspectDictionary(raw)
+	if err != nil {
+		return nil, fmt.Errorf("invalid dictionary: %w", err)
+	}
+	if info.ID() == 0 {
+		return nil, errors.New("invalid dictionary: dictionary ID must not be 0")
+	}
+
+	d := &Dictionary{id: info.ID(), raw: raw}
+	for level := zstd.SpeedFastest; level <= zstd.SpeedBestCompression; level++ {
+		d.encoders[level].New = func() interface{} {
+			encoder, _ := zstd.NewWriter(nil, zstd.WithEncoderLevel(level), zstd.WithEncoderDict(d.raw))
+			return encoder
+		}
+	}
+	d.decoders.New = func() interface{} {
+		decoder, _ := zstd.NewReader(nil, append(decoderLimits(), zstd.WithDecoderDicts(d.raw))...)
+		return decoder
+	}
+
+	// Build a decoder up front so a dictionary the library rejects fails here
+	// rather than inside a pool
+	decoder, err := zstd.NewReader(nil, append(decoderLimits(), zstd.WithDecoderDicts(d.raw))...)
+	if err != nil {
+		return nil, fmt.Errorf("invalid dictionary: %w", err)
+	}
+	d.decoders.Put(decoder)
+
+	return d, nil
+}
+
+// Compress compresses data at the given zstd level with this dictionary
+func (d *Dictionary) Compress(data, dst []byte, level int) []byte {
+	pool := &d.encoders[zstd.EncoderLevelFromZstd(level)]
+	encoder := pool.Get().(*zstd.Encoder)
+	defer pool.Put(encoder)
+
+	return encoder.EncodeAll(data, dst)
+}
+
+// Decompress decompresses a frame compressed with this dictionary
+func (d *Dictionary) Decompress(data, dst []byte) ([]byte, error) {
+	decoder := d.decoders.Get().(*zstd.Decoder)
+	defer d.decoders.Put(decoder)
+
+	return decoder.DecodeAll(data, dst)
+}
+
+// RegisterDictionary adds a zstd-format dictionary to the process-wide cache
+// and returns its ID. Registering the same dictionary again is a no-op.
+func RegisterDictionary(raw []byte) (uint32, error) {
+	d, err := newDictionary(bytes.Clone(raw))
+	if err != nil {
+		return 0, err
+	}
+
+	dictionaryCacheMu.Lock()
+	defer dictionaryCacheMu.Unlock()
+
+	if existing, ok := dictionaryCache.Load(d.id); ok {
+		if !bytes.Equal(existing.(*Dictionary).raw, d.raw) {
+			return 0, fmt.Errorf("a different dictionary is already registered with ID %d", d.id)
+		}
+		return d.id, nil
+	}
+
+	dictionaryCache.Store(d.id, d)
+	return d.id, nil
+}
+
+// lookupDictionary returns the registered dictionary with the given ID
+func lookupDictionary(id uint32) (*Dictionary, error) {
+	d, ok := dictionaryCache.Load(id)
+	if !ok {
+		return nil, fmt.Errorf("dictionary %d is not registered", id)
+	}
+	return d.(*Dictionary), nil
+}
+
+// TrainDictionary builds a zstd dictionary of at most maxSize bytes from
+// samples. The history is taken from the most recent samples; a zero id is
+// replaced by one derived from that history, outside the range reserved by
+// the zstd format.
+func TrainDictionary(samples [][]byte, id uint32, maxSize int) ([]byte, error) {
+	if len(samples) == 0 {
+		return nil, errors.New("no samples provided")
+	}
+	if maxSize < 256 || maxSize > maxDictionarySize {
+		return nil, fmt.Errorf("invalid dictionary size: %d (must be 256-%d)", maxSize, maxDictionarySize)
+	}
+
+	history := bytes.Join(samples, nil)
+	if len(history) > maxSize {
+		history = history[len(history)-maxSize:]
+	}
+	if len(history) < 8 {
+		return nil, errors.New("samples are too small to train a dictionary")
+	}
+
+	if id == 0 {
+		id = 32768 + crc32.ChecksumIEEE(history)%(1<<31-32768)
+	}
+
+	return zstd.BuildDict(zstd.BuildDictOptions{
+		ID:       id,
+		Contents: samples,
+		History:  history,
+		Offsets:  [3]int{1, 4, 8},
+	})
+}
+
+// frameDictionaryID returns the dictionary ID declared by the first frame of
+// data, or 0 when it has none
+func frameDictionaryID(data []byte) uint32 {
+	var header zstd.Header
+	if err := header.Decode(data); err != nil || header.Skippable {
+		return 0
+	}
+	return header.DictionaryID
+}
+
+// registeredDictionaries returns the raw content of every registered
+// dictionary, for decoders that must resolve any dictionary ID up front
+func registeredDictionaries() [][]byte {
+	var dictionaries [][]byte
+	dictionaryCache.Range(func(_, d interface{}) bool {
+		dictionaries = append(dictionaries, d.(*Dictionary).raw)
+		return true
+	})
+	return dictionaries
+}
@@ -0,0 +1,248 @@
+package franken_zstd
+
+//#include <zend.h>
+import "C"
+import (
+	"bufio"
+	"errors"
+	"fmt"
+	"io"
+	"io/fs"
+	"os"
+	"path/filepath"
+	"time"
+
+	"github.com/klauspost/compress/zstd"
+)
+
+// File to file compression runs entirely in Go: the PHP thread makes one
+// call per file, and the data never enters PHP memory. Compression reads
+// threads segments at a time with large reads, compresses them concurrently
+// into independent frames as the parallel path of Compressor does, and
+// writes the frames in order. Memory stays bounded by the segments in
+// flight, whatever the size of the file, and is charged to the memory
+// budget for the duration of the call.
+const (
+	// Size of the segments a file is compressed in, each into its own frame
+	fileSegmentSize = 4 << 20
+
+	// Window of the file encoder, covering a whole segment
+	fileWindowSize = 22
+
+	// Read buffer of the decompressing side and write buffer of its output
+	fileBufferSize = 1 << 20
+)
+
+// FileStats describes a file compression or decompression
+type FileStats struct {
+	BytesIn  int64
+	BytesOut int64
+	Time     time.Duration
+}
+
+// fileFootprint estimates the memory of a file compression: the segments
+// read and their frames, plus the encoder windows
+func fileFootprint(threads int) int64 {
+	return int64(threads)*int64(fileSegmentSize+compressBound(fileSegmentSize)) + codecFootprint(fileWindowSize, threads, 0)
+}
+
+// CompressFile compresses the file at source into destination, replacing
+// it once complete. With threads above 1, that many segments are
+// compressed in parallel. An empty source gives a single empty frame.
+func CompressFile(source, destination string, level int, dictID uint32, threads int) (FileStats, error) {
+	if level < 1 || level > 22 {
+		return FileStats{}, fmt.Errorf("invalid compression level: %d (must be 1-22)", level)
+	}
+	if threads < 1 || threads > 256 {
+		return FileStats{}, fmt.Errorf("invalid thread count: %d (must be 1-256)", threads)
+	}
+
+	encoderOptions, _, err := codecOptions(level, fileWindowSize, dictID)
+	if err != nil {
+		return FileStats{}, err
+	}
+
+	footprint := fileFootprint(threads)
+	if err := reserveMemory(footprint); err != nil {
+		return FileStats{}, err
+	}
+	defer releaseMemory(footprint)
+
+	encoder, err := zstd.NewWriter(nil, append(encoderOptions, zstd.WithEncoderConcurrency(threads))...)
+	if err != nil {
+		return FileStats{}, fmt.Errorf("failed to create encoder: %w", err)
+	}
+	defer encoder.Close()
+
+	startTime := time.Now()
+	stats, err := transformFile(source, destination, func(src io.Reader, dst io.Writer) (int64, int64, error) {
+		var read, written int64
+		data := make([]byte, threads*fileSegmentSize)
+		frames := make([]byte, 0, compressBound(len(data)))
+		for {
+			n, err := io.ReadFull(src, data)
+			if err != nil && err != io.ErrUnexpectedEOF && err != io.EOF {
+				return read, written, err
+			}
+			if n == 0 {
+				if read == 0 {
+					// An empty file still becomes a valid zstd stream
+					frames = encoder.EncodeAll(nil, frames[:0])
+					_, err := dst.Write(frames)
+					return read, int64(len(frames)), err
+				}
+				return read, written, nil
+			}
+
+			frames, _ = compressSegments(data[:n], frames[:0], fileSegmentSize, encoder.EncodeAll)
+			if _, err := dst.Write(frames); err != nil {
+				return read, written, err
+			}
+			read += int64(n)
+			written += int64(len(frames))
+		}
+	})
+	stats.Time = time.Since(startTime)
+	recordCompress(level, int(stats.BytesIn), int(stats.BytesOut), stats.Time, err)
+	return stats, err
+}
+
+// DecompressFile decompresses the file at source into destination,
+// replacing it once complete, and fails once the output would exceed
+// maxOutput bytes (0 for no limit). Memory is bounded by the windows of the
+// frames, capped like every decoder by the configured decoder memory limit.
+func DecompressFile(source, destination string, maxOutput int64) (FileStats, error) {
+	startTime := time.Now()
+	stats, err := transformFile(source, destination, func(src io.Reader, dst io.Writer) (int64, int64, error) {
+		counted := &countingReader{reader: bufio.NewReaderSize(src, fileBufferSize)}
+		decoder, err := zstd.NewReader(counted, append(decoderLimits(),
+			zstd.WithDecoderDicts(registeredDictionaries()...))...)
+		if err != nil {
+			return 0, 0, fmt.Errorf("failed to create decoder: %w", err)
+		}
+		defer decoder.Close()
+
+		var output io.Reader = decoder
+		if maxOutput > 0 {
+			// One byte past the limit tells an output of exactly maxOutput
+			// bytes from a larger one
+			output = io.LimitReader(decoder, maxOutput+1)
+		}
+
+		buffered := bufio.NewWriterSize(dst, fileBufferSize)
+		written, err := io.Copy(buffered, output)
+		if err == nil {
+			err = buffered.Flush()
+		}
+		if err == nil && maxOutput > 0 && written > maxOutput {
+			err = fmt.Errorf("decompressed size exceeds the limit of %d bytes", maxOutput)
+		}
+		return counted.count, written, err
+	})
+	stats.Time = time.Since(startTime)
+	recordDecompress(int(stats.BytesIn), int(stats.BytesOut), stats.Time, err)
+	return stats, err
+}
+
+// transformFile runs transform from source into a temporary file next to
+// destination, and renames it over destination only once it succeeded, so
+// a failure leaves an existing destination untouched. The temporary file
+// takes the permissions of the file it replaces, or 0644 for a new one.
+func transformFile(source, destination string, transform func(src io.Reader, dst io.Writer) (int64, int64, error)) (FileStats, error) {
+	src, err := os.Open(source)
+	if err != nil {
+		return FileStats{}, err
+	}
+	defer src.Close()
+
+	mode, err := destinationMode(src, destination)
+	if err != nil {
+		return FileStats{}, err
+	}
+
+	dst, err := os.CreateTemp(filepath.Dir(destination), "."+filepath.Base(destination)+".*.tmp")
+	if err != nil {
+		return FileStats{}, err
+	}
+	temporary := dst.Name()
+
+	var stats FileStats
+	stats.BytesIn, stats.BytesOut, err = transform(src, dst)
+	if err == nil {
+		err = dst.Chmod(mode)
+	}
+	if closeErr := dst.Close(); err == nil {
+		err = closeErr
+	}
+	if err == nil {
+		err = os.Rename(temporary, destination)
+	}
+	if err != nil {
+		os.Remove(temporary)
+	}
+	return stats, err
+}
+
+// destinationMode returns the permissions of the file destination replaces,
+// refusing a destination that is the source itself
+func destinationMode(src *os.File, destination string) (os.FileMode, error) {
+	dstInfo, err := os.Stat(destination)
+	if errors.Is(err, fs.ErrNotExist) {
+		return 0o644, nil
+	}
+	if err != nil {
+		return 0, err
+	}
+
+	srcInfo, err := src.Stat()
+	if err != nil {
+		return 0, err
+	}
+	if os.SameFile(srcInfo, dstInfo) {
+		return 0, errors.New("source and destination are the same file")
+	}
+	return dstInfo.Mode().Perm(), nil
+}
+
+// countingReader counts the bytes read through it
+type countingReader struct {
+	reader io.Reader
+	count  int64
+}
+
+func (r *countingReader) Read(p []byte) (int, error) {
+	n, err := r.reader.Read(p)
+	r.count += int64(n)
+	return n, err
+}
+
+// exportFileStats fills the out-parameters of a file export
+func exportFileStats(stats FileStats, bytesIn, bytesOut, nanoseconds *int64) {
+	*bytesIn = stats.BytesIn
+	*bytesOut = stats.BytesOut
+	*nanoseconds = int64(stats.Time)
+}
+
+// Paths are resolved against the PHP working directory by the C side
+//
+//export go_compress_file
+func go_compress_file(source, destination *C.char, level, dictID, threads int64, bytesIn, bytesOut, nanoseconds *int64) *C.char {
+	stats, err := CompressFile(C.GoString(source), C.GoString(destination), int(level), uint32(dictID), int(threads))
+	if err != nil {
+		return C.CString(err.Error())
+	}
+
+	exportFileStats(stats, bytesIn, bytesOut, nanoseconds)
+	return nil // Success
+}
+
+//export go_decompress_file
+func go_decompress_file(source, destination *C.char, maxOutput int64, bytesIn, bytesOut, nanoseconds *int64) *C.char {
+	stats, err := DecompressFile(C.GoString(source), C.GoString(destination), maxOutput)
+	if err != nil {
+		return C.CString(err.Error())
+	}
+
+	exportFileStats(stats, bytesIn, bytesOut, nanoseconds)
+	return nil // Success
+}
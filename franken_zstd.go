@@ -4,37 +4,64 @@ package franken_zstd
 //#include "zstd.h"
 import "C"
 import (
+	"bytes"
+	"errors"
 	"fmt"
+	"io"
+	"math"
+	"runtime"
+	"runtime/cgo"
+	"slices"
 	"sync"
+	"sync/atomic"
 	"time"
+	"unsafe"
 
 	"github.com/klauspost/compress/zstd"
 )
 
 func init() {
 	C.register_extension()
+
+	for level := zstd.SpeedFastest; level <= zstd.SpeedBestCompression; level++ {
+		encoderPools[level].New = func() interface{} {
+			encoder, _ := zstd.NewWriter(nil, zstd.WithEncoderLevel(level))
+			return encoder
+		}
+	}
 }
 
 // Global pools for efficiency
 var (
-	encoderPool = sync.Pool{
-		New: func() interface{} {
-			encoder, _ := zstd.NewWriter(nil, zstd.WithEncoderLevel(zstd.SpeedDefault))
-			return encoder
-		},
-	}
+	// One encoder pool per klauspost encoder level, indexed by zstd.EncoderLevel.
+	// Zstd levels 1-22 map onto these, so every level shares warm encoders with
+	// the levels that compress identically. Like any sync.Pool, idle encoders
+	// are dropped by the garbage collector.
+	encoderPools [zstd.SpeedBestCompression + 1]sync.Pool
+
+	// Fixed per-level free lists of the encoders preallocated at startup,
+	// nil until WarmEncoderPools runs. They are taken from before the pools
+	// and refilled first, so the warm encoders survive garbage collection.
+	warmEncoders atomic.Pointer[[zstd.SpeedBestCompression + 1]chan *zstd.Encoder]
 
 	decoderPool = sync.Pool{
 		New: func() interface{} {
-			decoder, _ := zstd.NewReader(nil)
+			decoder, _ := zstd.NewReader(nil, decoderLimits()...)
 			return decoder
 		},
 	}
 
-	compressorRegistry   = make(map[string]*Compressor)
-	compressorRegistryMu sync.RWMutex
+	// Bytes copied across the PHP/Go boundary because an output outgrew the
+	// buffer the C side allocated for it, or because shrinking that buffer
+	// to the output moved it
+	copiedBytes atomic.Int64
 )
 
+// A zstd block can describe at most 128KB with a 4-byte RLE block, so any
+// frame claiming a larger content size than this ratio allows is bogus and
+// must not drive preallocation.
+const maxFrameRatio = (128 << 10) / 4
+
 // Compression statistics
 type CompressionStats struct {
 	OriginalSize     int64
@@ -45,69 +72,430 @@ type CompressionStats struct {
 
 // Compressor instance
 type Compressor struct {
-	level      int
+	level      int // 0 for an adaptive compressor
 	windowSize int
-	encoder    *zstd.Encoder
-	decoder    *zstd.Decoder
-	stats      CompressionStats
-	mutex      sync.RWMutex
+	dictID     uint32
+	threads    int
+
+	// Level picker of an adaptive compressor, nil for a fixed level
+	adaptive *adaptiveController
+
+	// Encoder and decoder, nil while evicted. They are rebuilt lazily from
+	// the options under codecsMu, which eviction takes too.
+	codecs         atomic.Pointer[codecs]
+	codecsMu       sync.Mutex
+	encoderOptions []zstd.EOption
+	decoderOptions []zstd.DOption
+	footprint      int64
+	lastUsed       atomic.Int64
+
+	// Weight of the operations running on the codecs, and the windows
+	// charged for them on top of footprint, up to maxWindows
+	running    atomic.Int64
+	windows    atomic.Int64
+	maxWindows int64
+
+	// Stats of the latest operation, replaced as a whole so readers never see
+	// a mix of two operations
+	stats atomic.Pointer[CompressionStats]
+
+	// References held by the registry and by running operations. The codecs
+	// are closed when the last one is released, so Close never pulls them
+	// from under a concurrent call; eviction only takes them while the
+	// registry holds the sole reference.
+	refs   atomic.Int64
+	closed atomic.Bool
+
+	// Cumulative metrics
+	compressMetrics   operationMetrics
+	decompressMetrics operationMetrics
+}
+
+var errCompressorClosed = errors.New("compressor is closed")
+
+// codecs is the encoder and decoder of a compressor. An adaptive compressor
+// has an encoder per adaptive level instead of a single one.
+type codecs struct {
+	encoder  *zstd.Encoder
+	encoders [len(adaptiveLevels)]*zstd.Encoder
+	decoder  *zstd.Decoder
 }
 
-// NewCompressor creates a new compressor instance
-func NewCompressor(level, windowSize int) (*Compressor, error) {
+func (c *codecs) close() {
+	if c.encoder != nil {
+		c.encoder.Close()
+	}
+	for _, encoder := range c.encoders {
+		if encoder != nil {
+			encoder.Close()
+		}
+	}
+	if c.decoder != nil {
+		c.decoder.Close()
+	}
+}
+
+// NewCompressor creates a new compressor instance, optionally bound to a
+// registered dictionary (dictID 0 for none). With more than one thread, large
+// inputs are split into frames compressed in parallel.
+func NewCompressor(level, windowSize int, dictID uint32, threads int) (*Compressor, error) {
 	if level < 1 || level > 22 {
 		return nil, fmt.Errorf("invalid compression level: %d (must be 1-22)", level)
 	}
+	return newCompressor(level, windowSize, dictID, threads, nil)
+}
+
+// NewAdaptiveCompressor creates a compressor that picks its level per input
+// size class to encode at targetThroughput MB/s or more
+func NewAdaptiveCompressor(targetThroughput float64, windowSize int, dictID uint32, threads int) (*Compressor, error) {
+	adaptive, err := newAdaptiveController(targetThroughput)
+	if err != nil {
+		return nil, err
+	}
+	return newCompressor(0, windowSize, dictID, threads, adaptive)
+}
+
+func newCompressor(level, windowSize int, dictID uint32, threads int, adaptive *adaptiveController) (*Compressor, error) {
 	if windowSize < 10 || windowSize > 31 {
 		return nil, fmt.Errorf("invalid window size: %d (must be 10-31)", windowSize)
 	}
+	if threads < 1 || threads > 256 {
+		return nil, fmt.Errorf("invalid thread count: %d (must be 1-256)", threads)
+	}
 
-	encoder, err := zstd.NewWriter(nil,
-		zstd.WithEncoderLevel(zstd.EncoderLevelFromZstd(level)),
-		zstd.WithWindowSize(1<<windowSize))
+	encoderOptions, decoderOptions, err := codecOptions(max(level, 1), windowSize, dictID)
 	if err != nil {
-		return nil, fmt.Errorf("failed to create encoder: %w", err)
+		return nil, err
+	}
+
+	// EncodeAll and DecodeAll hand each concurrent call its own internal
+	// state with a window-sized history, so a shared compressor needs one
+	// per thread to serve them all without queueing. The library allocates
+	// that state only when a call first needs it, so the budget is charged
+	// up front for what a single operation uses, the encoders of a parallel
+	// compression and a decoder, and then a window per concurrent operation
+	// (see chargeWindows).
+	encoders := max(threads, runtime.GOMAXPROCS(0))
+	decoders := runtime.GOMAXPROCS(0)
+	encoderOptions = append(encoderOptions, zstd.WithEncoderConcurrency(encoders))
+	decoderOptions = append(decoderOptions, zstd.WithDecoderConcurrency(decoders))
+
+	levels := 1
+	if adaptive != nil {
+		levels = len(adaptiveLevels)
+	}
+	compressor := &Compressor{
+		level:          level,
+		windowSize:     windowSize,
+		dictID:         dictID,
+		threads:        threads,
+		adaptive:       adaptive,
+		encoderOptions: encoderOptions,
+		decoderOptions: decoderOptions,
+		footprint:      codecFootprint(windowSize, threads*levels, 1),
+		maxWindows:     int64(encoders*levels + decoders - threads*levels - 1),
 	}
 
-	decoder, err := zstd.NewReader(nil)
+	// Build the codecs up front, so invalid settings fail here
+	codecs, err := compressor.newCodecs()
 	if err != nil {
-		encoder.Close()
-		return nil, fmt.Errorf("failed to create decoder: %w", err)
+		return nil, err
+	}
+	compressor.codecs.Store(codecs)
+	compressor.lastUsed.Store(time.Now().UnixNano())
+	compressor.refs.Store(1)
+	return compressor, nil
+}
+
+// newCodecs builds the encoder and decoder within the memory budget
+func (c *Compressor) newCodecs() (*codecs, error) {
+	if err := reserveMemory(c.footprint); err != nil {
+		return nil, err
 	}
 
-	return &Compressor{
-		level:      level,
-		windowSize: windowSize,
-		encoder:    encoder,
-		decoder:    decoder,
-	}, nil
+	codecs, err := c.buildCodecs()
+	if err != nil {
+		codecs.close()
+		releaseMemory(c.footprint)
+		return nil, err
+	}
+	return codecs, nil
 }
 
-// Compress compresses data using zstd
-func (c *Compressor) Compress(data []byte) ([]byte, error) {
-	c.mutex.Lock()
-	defer c.mutex.Unlock()
+// buildCodecs builds the encoders and decoder from the options, returning
+// the ones built so far on error
+func (c *Compressor) buildCodecs() (*codecs, error) {
+	codecs := &codecs{}
+	var err error
+	if c.adaptive == nil {
+		if codecs.encoder, err = zstd.NewWriter(nil, c.encoderOptions...); err != nil {
+			return codecs, fmt.Errorf("failed to create encoder: %w", err)
+		}
+	} else {
+		for i, level := range adaptiveLevels {
+			options := append(slices.Clip(c.encoderOptions), zstd.WithEncoderLevel(zstd.EncoderLevelFromZstd(level)))
+			if codecs.encoders[i], err = zstd.NewWriter(nil, options...); err != nil {
+				return codecs, fmt.Errorf("failed to create encoder: %w", err)
+			}
+		}
+	}
 
-	startTime := time.Now()
-	compressed := c.encoder.EncodeAll(data, make([]byte, 0, len(data)))
-	compressionTime := time.Since(startTime)
+	if codecs.decoder, err = zstd.NewReader(nil, c.decoderOptions...); err != nil {
+		return codecs, fmt.Errorf("failed to create decoder: %w", err)
+	}
+	return codecs, nil
+}
+
+// codecOptions returns the encoder and decoder options for a level, window
+// size and optional registered dictionary
+func codecOptions(level, windowSize int, dictID uint32) ([]zstd.EOption, []zstd.DOption, error) {
+	encoderOptions := []zstd.EOption{
+		zstd.WithEncoderLevel(zstd.EncoderLevelFromZstd(level)),
+		zstd.WithWindowSize(1 << windowSize),
+	}
+	decoderOptions := decoderLimits()
+	if dictID != 0 {
+		dictionary, err := lookupDictionary(dictID)
+		if err != nil {
+			return nil, nil, err
+		}
+		encoderOptions = append(encoderOptions, zstd.WithEncoderDict(dictionary.raw))
+		decoderOptions = append(decoderOptions, zstd.WithDecoderDicts(dictionary.raw))
+	}
+	return encoderOptions, decoderOptions, nil
+}
+
+// acquire takes a reference for an operation running concurrency codec
+// calls at once and returns the codecs, rebuilding them if they were
+// evicted. It fails once the compressor is closed, or when the windows of
+// the operation do not fit in the memory budget. Every successful acquire
+// is paired with a done of the same concurrency.
+func (c *Compressor) acquire(concurrency int) (*codecs, error) {
+	for {
+		refs := c.refs.Load()
+		if refs == 0 || c.closed.Load() {
+			return nil, errCompressorClosed
+		}
+		if c.refs.CompareAndSwap(refs, refs+1) {
+			break
+		}
+	}
+	c.lastUsed.Store(time.Now().UnixNano())
+
+	// The reference is taken before the codecs are loaded, so an eviction
+	// either sees it and backs off or has already cleared the pointer
+	codecs := c.codecs.Load()
+	if codecs == nil {
+		var err error
+		if codecs, err = c.restore(); err != nil {
+			c.release()
+			return nil, err
+		}
+	}
+
+	running := c.running.Add(int64(concurrency))
+	if err := c.chargeWindows(running); err != nil {
+		c.done(concurrency)
+		return nil, err
+	}
+	return codecs, nil
+}
+
+// chargeWindows charges the budget a window for every concurrent codec call
+// beyond the first that the codecs have not served before. The library keeps
+// the state of such calls once allocated, so the charge lasts until the
+// codecs are dropped.
+func (c *Compressor) chargeWindows(running int64) error {
+	window := int64(1) << c.windowSize
+	for {
+		charged := c.windows.Load()
+		if running-1 <= charged || charged >= c.maxWindows {
+			return nil
+		}
+		if err := reserveMemory(window); err != nil {
+			return err
+		}
+		if !c.windows.CompareAndSwap(charged, charged+1) {
+			releaseMemory(window)
+		}
+	}
+}
+
+// done ends an operation started by acquire
+func (c *Compressor) done(concurrency int) {
+	c.running.Add(-int64(concurrency))
+	c.release()
+}
+
+// releaseCodecMemory returns the memory charged for the codecs to the
+// budget, and how much that was
+func (c *Compressor) releaseCodecMemory() int64 {
+	n := c.footprint + c.windows.Swap(0)<<c.windowSize
+	releaseMemory(n)
+	return n
+}
+
+// restore rebuilds evicted codecs
+func (c *Compressor) restore() (*codecs, error) {
+	c.codecsMu.Lock()
+	defer c.codecsMu.Unlock()
+
+	if codecs := c.codecs.Load(); codecs != nil {
+		return codecs, nil
+	}
+	codecs, err := c.newCodecs()
+	if err != nil {
+		return nil, err
+	}
+	c.codecs.Store(codecs)
+	return codecs, nil
+}
+
+// release drops a reference, closing the codecs with the last one
+func (c *Compressor) release() {
+	if c.refs.Add(-1) == 0 {
+		c.dropCodecs()
+	}
+}
+
+// dropCodecs closes the codecs and returns their memory to the budget
+func (c *Compressor) dropCodecs() bool {
+	codecs := c.codecs.Swap(nil)
+	if codecs == nil {
+		return false
+	}
+	codecs.close()
+	c.releaseCodecMemory()
+	return true
+}
+
+// evict closes the codecs of an idle compressor; the next operation
+// rebuilds them. It returns the memory released, or 0 when it backed off
+// because an operation holds a reference or the codecs are being rebuilt.
+func (c *Compressor) evict() int64 {
+	if !c.codecsMu.TryLock() {
+		return 0
+	}
+	defer c.codecsMu.Unlock()
+
+	codecs := c.codecs.Swap(nil)
+	if codecs == nil {
+		return 0
+	}
+	if c.refs.Load() > 1 {
+		c.codecs.Store(codecs)
+		// A Close that dropped the last reference meanwhile found no codecs
+		if c.refs.Load() == 0 {
+			c.dropCodecs()
+		}
+		return 0
+	}
+
+	codecs.close()
+	evictions.Add(1)
+	return c.releaseCodecMemory()
+}
 
-	c.stats = CompressionStats{
-		OriginalSize:     int64(len(data)),
-		CompressedSize:   int64(len(compressed)),
-		CompressionRatio: float64(len(data)) / float64(len(compressed)),
+// setStats publishes the stats of the latest operation
+func (c *Compressor) setStats(originalSize, compressedSize int64, compressionTime time.Duration) {
+	ratio := 0.0
+	if compressedSize > 0 {
+		ratio = float64(originalSize) / float64(compressedSize)
+	}
+	c.stats.Store(&CompressionStats{
+		OriginalSize:     originalSize,
+		CompressedSize:   compressedSize,
+		CompressionRatio: ratio,
 		CompressionTime:  compressionTime,
+	})
+}
+
+// Compress compresses data using zstd, appending to dst. Any number of
+// threads may call it at once.
+func (c *Compressor) Compress(data, dst []byte) ([]byte, error) {
+	codecs, err := c.acquire(1)
+	if err != nil {
+		return nil, err
 	}
+	defer c.done(1)
+
+	startTime := time.Now()
+	compressed, level := c.encode(codecs, data, dst)
+	compressionTime := time.Since(startTime)
+
+	c.setStats(int64(len(data)), int64(len(compressed)), compressionTime)
+	c.recordCompress(level, len(data), len(compressed)-len(dst), compressionTime, nil)
 
 	return compressed, nil
 }
 
-// Decompress decompresses zstd-compressed data
-func (c *Compressor) Decompress(compressedData []byte) ([]byte, error) {
-	c.mutex.Lock()
-	defer c.mutex.Unlock()
+// encode compresses data with the encoder of the compressor's level, or of
+// the level an adaptive compressor picks for its size, and returns the level
+func (c *Compressor) encode(codecs *codecs, data, dst []byte) ([]byte, int) {
+	level, index, encoder := c.level, 0, codecs.encoder
+	if c.adaptive != nil {
+		index = c.adaptive.level(len(data))
+		level, encoder = adaptiveLevels[index], codecs.encoders[index]
+	}
+
+	key := cacheKey{level: level, windowSize: c.windowSize, dictID: c.dictID}
+	compressed := cachedCompress(data, dst, key, func(data, dst []byte) []byte {
+		startTime := time.Now()
+		var out []byte
+		if c.threads > 1 && len(data) >= 2*parallelMinSegment {
+			out = compressParallel(encoder, data, dst, c.threads)
+		} else {
+			out = encoder.EncodeAll(data, dst)
+		}
+		// Only actual encodes are timed, never cache hits
+		if c.adaptive != nil {
+			c.adaptive.observe(len(data), index, time.Since(startTime))
+		}
+		return out
+	})
+	return compressed, level
+}
 
-	decompressed, err := c.decoder.DecodeAll(compressedData, nil)
+// recordCompress adds a compression to the metrics of the compressor and of
+// the level it used
+func (c *Compressor) recordCompress(level, in, out int, elapsed time.Duration, err error) {
+	c.compressMetrics.record(in, out, elapsed, err)
+	recordCompress(level, in, out, elapsed, err)
+}
+
+// recordDecompress adds a decompression to the metrics of the compressor and
+// of the process
+func (c *Compressor) recordDecompress(in, out int, elapsed time.Duration, err error) {
+	c.decompressMetrics.record(in, out, elapsed, err)
+	recordDecompress(in, out, elapsed, err)
+}
+
+// Decompress decompresses zstd-compressed data, appending to dst and
+// producing at most maxOutput bytes (0 for no limit). Frames compressed with
+// another registered dictionary are routed to it. Any number of threads may
+// call it at once.
+func (c *Compressor) Decompress(compressedData, dst []byte, maxOutput int64) ([]byte, error) {
+	codecs, err := c.acquire(1)
+	if err != nil {
+		return nil, err
+	}
+	defer c.done(1)
+
+	startTime := time.Now()
+	decompressed, err := decompressWithin(compressedData, dst, maxOutput, func(data, dst []byte) ([]byte, error) {
+		return c.decompress(codecs.decoder, data, dst)
+	})
+	c.recordDecompress(len(compressedData), len(decompressed)-len(dst), time.Since(startTime), err)
+
+	return decompressed, err
+}
+
+func (c *Compressor) decompress(decoder *zstd.Decoder, compressedData, dst []byte) ([]byte, error) {
+	if id := frameDictionaryID(compressedData); id != 0 && id != c.dictID {
+		return decompressWithDictionary(id, compressedData, dst)
+	}
+
+	decompressed, err := decoder.DecodeAll(compressedData, dst)
 	if err != nil {
 		return nil, fmt.Errorf("decompression failed: %w", err)
 	}
@@ -115,115 +503,80 @@ func (c *Compressor) Decompress(compressedData []byte) ([]byte, error) {
 	return decompressed, nil
 }
 
-// Close releases resources
+// Close releases resources once the running operations complete. New
+// operations fail from now on.
 func (c *Compressor) Close() {
-	c.mutex.Lock()
-	defer c.mutex.Unlock()
-
-	if c.encoder != nil {
-		c.encoder.Close()
-		c.encoder = nil
-	}
-	if c.decoder != nil {
-		c.decoder.Close()
-		c.decoder = nil
+	if c.closed.CompareAndSwap(false, true) {
+		c.release()
 	}
 }
 
 //export go_compressor_create
-func go_compressor_create(phpName *C.zend_string, level, windowSize int64) *C.char {
-	name := zendStringToGoString(phpName)
-
-	compressorRegistryMu.Lock()
-	defer compressorRegistryMu.Unlock()
-
-	// Check if compressor already exists
-	if _, exists := compressorRegistry[name]; exists {
-		return nil // Success, compressor already exists
+func go_compressor_create(level, windowSize, dictID, threads int64, handle *C.uint64_t) *C.char {
+	compressor, err := NewCompressor(int(level), int(windowSize), uint32(dictID), int(threads))
+	if err != nil {
+		return C.CString(err.Error())
 	}
 
-	compressor, err := NewCompressor(int(level), int(windowSize))
+	h, err := compressorRegistry.register(compressor)
 	if err != nil {
+		compressor.Close()
 		return C.CString(err.Error())
 	}
 
-	compressorRegistry[name] = compressor
+	*handle = C.uint64_t(h)
 	return nil // Success
 }
 
 //export go_compressor_compress
-func go_compressor_compress(phpName *C.zend_string, data *C.zend_string, result **C.char, resultLen *C.int, error **C.char) {
-	name := zendStringToGoString(phpName)
-	inputData := zendStringToGoBytes(data)
-
-	compressorRegistryMu.RLock()
-	compressor, exists := compressorRegistry[name]
-	compressorRegistryMu.RUnlock()
-
-	if !exists {
-		*error = C.CString("compressor not found")
+func go_compressor_compress(handle C.uint64_t, data *C.zend_string, result *C.zend_string, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	compressor, err := compressorRegistry.lookup(uint64(handle))
+	if err != nil {
+		*error = C.CString(err.Error())
 		return
 	}
 
-	compressed, err := compressor.Compress(inputData)
+	buf := zendStringBuffer(result)
+	compressed, err := compressor.Compress(zendStringBytes(data), buf)
 	if err != nil {
 		*error = C.CString(err.Error())
 		return
 	}
 
-	// Use binary-safe conversion
-	*result = (*C.char)(C.CBytes(compressed))
-	*resultLen = C.int(len(compressed))
+	storeResult(buf, compressed, resultLen, pending)
 }
 
 //export go_compressor_decompress
-func go_compressor_decompress(phpName *C.zend_string, compressedData *C.zend_string, result **C.char, resultLen *C.int, error **C.char) {
-	name := zendStringToGoString(phpName)
-	inputData := zendStringToGoBytes(compressedData)
-
-	compressorRegistryMu.RLock()
-	compressor, exists := compressorRegistry[name]
-	compressorRegistryMu.RUnlock()
-
-	if !exists {
-		*error = C.CString("compressor not found")
+func go_compressor_decompress(handle C.uint64_t, compressedData *C.zend_string, maxOutput int64, result *C.zend_string, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	compressor, err := compressorRegistry.lookup(uint64(handle))
+	if err != nil {
+		*error = C.CString(err.Error())
 		return
 	}
 
-	decompressed, err := compressor.Decompress(inputData)
+	buf := zendStringBuffer(result)
+	decompressed, err := compressor.Decompress(zendStringBytes(compressedData), buf, maxOutput)
 	if err != nil {
 		*error = C.CString(err.Error())
 		return
 	}
 
-	// Use binary-safe conversion
-	*result = (*C.char)(C.CBytes(decompressed))
-	*resultLen = C.int(len(decompressed))
+	storeResult(buf, decompressed, resultLen, pending)
 }
 
 //export go_compressor_get_stats
-func go_compressor_get_stats(phpName *C.zend_string, originalSize, compressedSize *int64, compressionRatio *float64, compressionTime *int64, error **C.char) {
-	// Safety check for null pointer
-	if phpName == nil {
-		*error = C.CString("null compressor name")
+func go_compressor_get_stats(handle C.uint64_t, originalSize, compressedSize *int64, compressionRatio *float64, compressionTime *int64, compressTotals, decompressTotals *C.franken_zstd_totals, error **C.char) {
+	compressor, err := compressorRegistry.lookup(uint64(handle))
+	if err != nil {
+		*error = C.CString(err.Error())
 		return
 	}
 
-	name := zendStringToGoString(phpName)
-
-	compressorRegistryMu.RLock()
-	compressor, exists := compressorRegistry[name]
-	compressorRegistryMu.RUnlock()
-
-	if !exists {
-		*error = C.CString(fmt.Sprintf("compressor not found: %s", name))
-		return
+	var stats CompressionStats
+	if latest := compressor.stats.Load(); latest != nil {
+		stats = *latest
 	}
 
-	compressor.mutex.RLock()
-	stats := compressor.stats
-	compressor.mutex.RUnlock()
-
 	// Safely assign values, ensuring pointers are valid
 	if originalSize != nil {
 		*originalSize = stats.OriginalSize
@@ -237,77 +590,563 @@ func go_compressor_get_stats(phpName *C.zend_string, originalSize, compressedSiz
 	if compressionTime != nil {
 		*compressionTime = int64(stats.CompressionTime.Nanoseconds())
 	}
+
+	// Cumulative totals are read from atomics
+	if compressTotals != nil {
+		compressor.compressMetrics.export(compressTotals)
+	}
+	if decompressTotals != nil {
+		compressor.decompressMetrics.export(decompressTotals)
+	}
 }
 
 //export go_compressor_close
-func go_compressor_close(phpName *C.zend_string) *C.char {
-	name := zendStringToGoString(phpName)
-
-	compressorRegistryMu.Lock()
-	defer compressorRegistryMu.Unlock()
-
-	compressor, exists := compressorRegistry[name]
-	if !exists {
-		return C.CString("compressor not found")
+func go_compressor_close(handle C.uint64_t) *C.char {
+	compressor, err := compressorRegistry.unregister(uint64(handle))
+	if err != nil {
+		return C.CString(err.Error())
 	}
 
 	compressor.Close()
-	delete(compressorRegistry, name)
 	return nil // Success
 }
 
 // Quick compress function for simple use cases
 //
 //export go_quick_compress
-func go_quick_compress(data *C.zend_string, level int64, result **C.char, resultLen *C.int, error **C.char) {
-	inputData := zendStringToGoBytes(data)
-
-	encoder := encoderPool.Get().(*zstd.Encoder)
-	defer encoderPool.Put(encoder)
-
-	// Reset encoder with new level
-	encoder.Reset(nil)
-
-	compressed := encoder.EncodeAll(inputData, make([]byte, 0, len(inputData)))
-	// Use binary-safe conversion
-	if len(compressed) > 0 {
-		*result = (*C.char)(C.CBytes(compressed))
-		*resultLen = C.int(len(compressed))
-	} else {
-		*resultLen = 0
+func go_quick_compress(data *C.zend_string, level, dictID int64, result *C.zend_string, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	buf := zendStringBuffer(result)
+	input := zendStringBytes(data)
+	startTime := time.Now()
+	compressed, err := quickCompress(input, buf, int(level), uint32(dictID))
+	recordCompress(int(level), len(input), len(compressed), time.Since(startTime), err)
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
 	}
+
+	storeResult(buf, compressed, resultLen, pending)
 }
 
 // Quick decompress function for simple use cases
 //
 //export go_quick_decompress
-func go_quick_decompress(compressedData *C.zend_string, result **C.char, resultLen *C.int, error **C.char) {
-	inputData := zendStringToGoBytes(compressedData)
+func go_quick_decompress(compressedData *C.zend_string, maxOutput int64, result *C.zend_string, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	buf := zendStringBuffer(result)
+	input := zendStringBytes(compressedData)
+	startTime := time.Now()
+	decompressed, err := decompressWithin(input, buf, maxOutput, quickDecompress)
+	recordDecompress(len(input), len(decompressed), time.Since(startTime), err)
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	storeResult(buf, decompressed, resultLen, pending)
+}
+
+// quickCompress compresses data with a pooled encoder of the given level,
+// using a registered dictionary when dictID is not 0
+func quickCompress(data, dst []byte, level int, dictID uint32) ([]byte, error) {
+	if level < 1 || level > 22 {
+		return nil, fmt.Errorf("invalid compression level: %d (must be 1-22)", level)
+	}
+
+	var dictionary *Dictionary
+	if dictID != 0 {
+		var err error
+		if dictionary, err = lookupDictionary(dictID); err != nil {
+			return nil, err
+		}
+	}
+
+	key := cacheKey{level: level, dictID: dictID}
+	return cachedCompress(data, dst, key, func(data, dst []byte) []byte {
+		if dictionary != nil {
+			return dictionary.Compress(data, dst, level)
+		}
+
+		encoderLevel := zstd.EncoderLevelFromZstd(level)
+		encoder := getEncoder(encoderLevel)
+		defer putEncoder(encoderLevel, encoder)
+
+		return encoder.EncodeAll(data, dst)
+	}), nil
+}
+
+// quickDecompress decompresses data with a pooled decoder, picking the
+// dictionary from the frame header when the frame declares one
+func quickDecompress(data, dst []byte) ([]byte, error) {
+	if id := frameDictionaryID(data); id != 0 {
+		return decompressWithDictionary(id, data, dst)
+	}
 
 	decoder := decoderPool.Get().(*zstd.Decoder)
 	defer decoderPool.Put(decoder)
 
-	decompressed, err := decoder.DecodeAll(inputData, nil)
+	return decoder.DecodeAll(data, dst)
+}
+
+func decompressWithDictionary(id uint32, data, dst []byte) ([]byte, error) {
+	dictionary, err := lookupDictionary(id)
+	if err != nil {
+		return nil, err
+	}
+	return dictionary.Decompress(data, dst)
+}
+
+// decompressWithin decodes data with decode while making sure the output
+// cannot exceed maxOutput bytes (0 for no limit). Payloads declaring more
+// fail before any decoding, and those whose block bound exceeds the limit
+// are decoded incrementally until they hit it.
+func decompressWithin(data, dst []byte, maxOutput int64, decode func(data, dst []byte) ([]byte, error)) ([]byte, error) {
+	if maxOutput <= 0 {
+		return decode(data, dst)
+	}
+
+	bound, exact := decompressedBound(data)
+	switch {
+	case exact && bound > maxOutput:
+		return nil, fmt.Errorf("decompressed size of %d bytes exceeds the limit of %d bytes", bound, maxOutput)
+	case bound >= 0 && bound <= maxOutput:
+		return decode(data, dst)
+	default:
+		return decompressLimited(data, dst, maxOutput)
+	}
+}
+
+// decompressLimited streams data through a decoder into dst, growing the
+// output geometrically but never past maxOutput, and fails as soon as the
+// output would exceed it
+func decompressLimited(data, dst []byte, maxOutput int64) ([]byte, error) {
+	decoder, err := zstd.NewReader(bytes.NewReader(data), append(decoderLimits(),
+		zstd.WithDecoderConcurrency(1),
+		zstd.WithDecoderDicts(registeredDictionaries()...))...)
+	if err != nil {
+		return nil, fmt.Errorf("failed to create decoder: %w", err)
+	}
+	defer decoder.Close()
+
+	// One byte past the limit tells an output of exactly maxOutput bytes from
+	// a larger one
+	limit := len(dst) + int(min(maxOutput, math.MaxInt64-int64(len(dst))-1)) + 1
+	out := dst
+	for {
+		if len(out) == cap(out) {
+			grow := min(max(cap(out)-len(dst), 64<<10), limit-len(out))
+			out = slices.Grow(out, grow)
+		}
+		n, err := decoder.Read(out[len(out):min(cap(out), limit)])
+		out = out[:len(out)+n]
+		if len(out) >= limit {
+			return nil, fmt.Errorf("decompressed size exceeds the limit of %d bytes", maxOutput)
+		}
+		if err == io.EOF {
+			return out, nil
+		}
+		if err != nil {
+			return nil, fmt.Errorf("decompression failed: %w", err)
+		}
+	}
+}
+
+//export go_train_dictionary
+func go_train_dictionary(samples **C.zend_string, count C.size_t, dictID, maxSize int64, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	phpSamples := unsafe.Slice(samples, int(count))
+	goSamples := make([][]byte, len(phpSamples))
+	for i, sample := range phpSamples {
+		goSamples[i] = zendStringBytes(sample)
+	}
+
+	dictionary, err := TrainDictionary(goSamples, uint32(dictID), int(maxSize))
 	if err != nil {
 		*error = C.CString(err.Error())
 		return
 	}
 
-	// Use binary-safe conversion
-	if len(decompressed) > 0 {
-		*result = (*C.char)(C.CBytes(decompressed))
-		*resultLen = C.int(len(decompressed))
-	} else {
-		*resultLen = 0
+	storeResult(nil, dictionary, resultLen, pending)
+}
+
+//export go_register_dictionary
+func go_register_dictionary(dictionary *C.zend_string, dictID *int64) *C.char {
+	id, err := RegisterDictionary(zendStringBytes(dictionary))
+	if err != nil {
+		return C.CString(err.Error())
 	}
+
+	*dictID = int64(id)
+	return nil // Success
+}
+
+//export go_stream_compressor_create
+func go_stream_compressor_create(level, windowSize, dictID int64, handle *C.uint64_t) *C.char {
+	stream, err := NewStreamCompressor(int(level), int(windowSize), uint32(dictID))
+	if err != nil {
+		return C.CString(err.Error())
+	}
+
+	h, err := streamCompressorRegistry.register(stream)
+	if err != nil {
+		stream.Close()
+		return C.CString(err.Error())
+	}
+
+	*handle = C.uint64_t(h)
+	return nil // Success
+}
+
+//export go_stream_compressor_write
+func go_stream_compressor_write(handle C.uint64_t, data *C.char, dataLen C.size_t, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	stream, err := streamCompressorRegistry.lookup(uint64(handle))
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	out, err := stream.Write(cBytes(data, dataLen))
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	storeResult(nil, out, resultLen, pending)
+}
+
+//export go_stream_compressor_flush
+func go_stream_compressor_flush(handle C.uint64_t, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	stream, err := streamCompressorRegistry.lookup(uint64(handle))
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	out, err := stream.Flush()
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	storeResult(nil, out, resultLen, pending)
+}
+
+//export go_stream_compressor_finish
+func go_stream_compressor_finish(handle C.uint64_t, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	stream, err := streamCompressorRegistry.lookup(uint64(handle))
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	out, err := stream.Finish()
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	storeResult(nil, out, resultLen, pending)
+}
+
+//export go_stream_compressor_close
+func go_stream_compressor_close(handle C.uint64_t) *C.char {
+	stream, err := streamCompressorRegistry.unregister(uint64(handle))
+	if err != nil {
+		return C.CString(err.Error())
+	}
+
+	stream.Close()
+	return nil // Success
+}
+
+//export go_stream_decompressor_create
+func go_stream_decompressor_create(maxWindowSize int64, handle *C.uint64_t) *C.char {
+	stream, err := NewStreamDecompressor(int(maxWindowSize))
+	if err != nil {
+		return C.CString(err.Error())
+	}
+
+	h, err := streamDecompressorRegistry.register(stream)
+	if err != nil {
+		stream.Close()
+		return C.CString(err.Error())
+	}
+
+	*handle = C.uint64_t(h)
+	return nil // Success
+}
+
+//export go_stream_decompressor_write
+func go_stream_decompressor_write(handle C.uint64_t, data *C.char, dataLen C.size_t, maxLength int64, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	stream, err := streamDecompressorRegistry.lookup(uint64(handle))
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	out, err := stream.Write(cBytes(data, dataLen), int(maxLength))
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	storeResult(nil, out, resultLen, pending)
+}
+
+//export go_stream_decompressor_read
+func go_stream_decompressor_read(handle C.uint64_t, maxLength int64, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	stream, err := streamDecompressorRegistry.lookup(uint64(handle))
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	out, err := stream.Read(int(maxLength))
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	storeResult(nil, out, resultLen, pending)
+}
+
+//export go_stream_decompressor_finish
+func go_stream_decompressor_finish(handle C.uint64_t, maxLength int64, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	stream, err := streamDecompressorRegistry.lookup(uint64(handle))
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	out, err := stream.Finish(int(maxLength))
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	storeResult(nil, out, resultLen, pending)
+}
+
+//export go_stream_decompressor_close
+func go_stream_decompressor_close(handle C.uint64_t) *C.char {
+	stream, err := streamDecompressorRegistry.unregister(uint64(handle))
+	if err != nil {
+		return C.CString(err.Error())
+	}
+
+	stream.Close()
+	return nil // Success
+}
+
+// WarmEncoderPools preallocates count encoders for every encoder level, so
+// requests do not pay for encoder construction. They are kept in fixed free
+// lists rather than in the pools, which the garbage collector empties, so
+// up to count encoders per level stay warm for the life of the process.
+func WarmEncoderPools(count int) {
+	var lists [zstd.SpeedBestCompression + 1]chan *zstd.Encoder
+	for level := zstd.SpeedFastest; level <= zstd.SpeedBestCompression; level++ {
+		lists[level] = make(chan *zstd.Encoder, count)
+		for i := 0; i < count; i++ {
+			lists[level] <- encoderPools[level].New().(*zstd.Encoder)
+		}
+	}
+	warmEncoders.Store(&lists)
+}
+
+// getEncoder takes an encoder of a level, from the warm free list first
+func getEncoder(level zstd.EncoderLevel) *zstd.Encoder {
+	if lists := warmEncoders.Load(); lists != nil {
+		select {
+		case encoder := <-lists[level]:
+			return encoder
+		default:
+		}
+	}
+	return encoderPools[level].Get().(*zstd.Encoder)
+}
+
+// putEncoder returns an encoder taken by getEncoder, refilling the warm free
+// list first
+func putEncoder(level zstd.EncoderLevel, encoder *zstd.Encoder) {
+	if lists := warmEncoders.Load(); lists != nil {
+		select {
+		case lists[level] <- encoder:
+			return
+		default:
+		}
+	}
+	encoderPools[level].Put(encoder)
+}
+
+// Capacity the C side preallocates for the output of a payload: the content
+// size declared by its frames, or for frames without one the bound derived
+// from their blocks, capped to a multiple of the input so a crafted payload
+// cannot force a huge allocation up front. Never more than maxOutput when it
+// is set. Returns -1 when unknown.
+//
+//export go_decompressed_size
+func go_decompressed_size(compressedData *C.zend_string, maxOutput int64) int64 {
+	return decompressedSize(zendStringBytes(compressedData), maxOutput)
+}
+
+// Capacities of every item of a batch, as go_decompressed_size, in a single
+// call
+//
+//export go_decompressed_sizes
+func go_decompressed_sizes(items **C.zend_string, count C.size_t, maxOutput int64, sizes *int64) {
+	results := unsafe.Slice(sizes, int(count))
+	for i, item := range unsafe.Slice(items, int(count)) {
+		results[i] = decompressedSize(zendStringBytes(item), maxOutput)
+	}
+}
+
+func decompressedSize(data []byte, maxOutput int64) int64 {
+	size, exact := decompressedBound(data)
+	if size < 0 {
+		return -1
+	}
+	if !exact {
+		size = min(size, int64(len(data))*unknownSizeRatio+unknownSizeSlack)
+	}
+	if maxOutput > 0 && size > maxOutput {
+		if exact {
+			return -1 // Fails before decoding anyway
+		}
+		size = maxOutput
+	}
+	return size
+}
+
+// Preallocation for frames that do not declare their content size. Their
+// output then grows by appending, never past the block bound.
+const (
+	unknownSizeRatio = 32
+	unknownSizeSlack = 128 << 10
+)
+
+// Largest decompressed size of a zstd block
+const maxBlockSize = 128 << 10
+
+// decompressedBound walks the frames of data and returns the content size
+// they declare, with exact set, or when some frame does not declare one an
+// upper bound derived from its block headers. Walking a frame only reads its
+// 3-byte block headers. Returns -1 when data is malformed or declares more
+// than its size allows.
+func decompressedBound(data []byte) (int64, bool) {
+	limit := uint64(len(data)) * maxFrameRatio
+	var total uint64
+	exact := true
+	for len(data) > 0 {
+		var header zstd.Header
+		if err := header.Decode(data); err != nil {
+			return -1, false
+		}
+		if header.Skippable {
+			size := 8 + int(header.SkippableSize)
+			if size > len(data) {
+				return -1, false
+			}
+			data = data[size:]
+			continue
+		}
+
+		size, bound := frameSize(data, &header)
+		if size < 0 {
+			return -1, false
+		}
+		if header.HasFCS {
+			total += header.FrameContentSize
+		} else {
+			total += bound
+			exact = false
+		}
+		if total > limit {
+			return -1, false
+		}
+		data = data[size:]
+	}
+	return int64(total), exact
+}
+
+// frameSize returns the compressed size of the frame at the start of data,
+// or -1 when the frame is truncated or malformed, along with an upper bound
+// of its decompressed size: raw and RLE blocks declare theirs, compressed
+// blocks decode to at most a block
+func frameSize(data []byte, header *zstd.Header) (int, uint64) {
+	pos := header.HeaderSize
+	var bound uint64
+	for {
+		if pos+3 > len(data) {
+			return -1, 0
+		}
+		blockHeader := uint32(data[pos]) | uint32(data[pos+1])<<8 | uint32(data[pos+2])<<16
+		blockSize := int(blockHeader >> 3)
+		pos += 3
+
+		switch blockType := (blockHeader >> 1) & 3; blockType {
+		case 0: // Raw
+			pos += blockSize
+			bound += uint64(blockSize)
+		case 1: // RLE: a single byte repeated
+			pos++
+			bound += uint64(blockSize)
+		case 2: // Compressed
+			pos += blockSize
+			bound += maxBlockSize
+		default: // Reserved
+			return -1, 0
+		}
+		if blockHeader&1 != 0 {
+			break
+		}
+	}
+	if header.HasCheckSum {
+		pos += 4
+	}
+	if pos > len(data) {
+		return -1, 0
+	}
+	return pos, bound
+}
+
+// storeResult reports an output to the C side. When out still lives in buf,
+// the C-allocated zend_string, only its length is returned. Otherwise the
+// output outgrew buf and is parked behind a handle for go_result_take.
+func storeResult(buf, out []byte, resultLen *C.size_t, pending *C.uintptr_t) {
+	*resultLen = C.size_t(len(out))
+	if len(out) == 0 {
+		return
+	}
+	if cap(buf) > 0 && &out[0] == &buf[:1][0] {
+		return
+	}
+	*pending = C.uintptr_t(cgo.NewHandle(out))
+}
+
+// Copies a parked output into a buffer allocated with its exact size
+//
+//export go_result_take
+func go_result_take(pending C.uintptr_t, result *C.char) {
+	handle := cgo.Handle(pending)
+	out := handle.Value().([]byte)
+	handle.Delete()
+
+	copy(cBytes(result, C.size_t(len(out))), out)
+	copiedBytes.Add(int64(len(out)))
+}
+
+// Counts a copy made by the C side when shrinking an output buffer
+//
+//export go_record_copy
+func go_record_copy(size C.size_t) {
+	copiedBytes.Add(int64(size))
 }
 
 // Get zstd information
 //
 //export go_get_zstd_info
-func go_get_zstd_info(version **C.char, maxLevel, minLevel, defaultLevel *int64) {
+func go_get_zstd_info(version **C.char, maxLevel, minLevel, defaultLevel, bytesCopied *int64) {
 	*version = C.CString("1.0.3")
 	*maxLevel = 22
 	*minLevel = 1
 	*defaultLevel = 3
+	*bytesCopied = copiedBytes.Load()
 }
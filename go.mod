@@ -4,8 +4,10 @@ go 1.25.0
 
 require (
 	github.com/caddyserver/caddy/v2 v2.10.2
+	github.com/cespare/xxhash/v2 v2.3.0
 	github.com/dunglas/frankenphp v1.9.1
 	github.com/klauspost/compress v1.18.0
+	github.com/prometheus/client_golang v1.23.0
 	go.uber.org/zap v1.27.0
 )
 
@@ -13,7 +15,6 @@ require (
 	github.com/beorn7/perks v1.0.1 // indirect
 	github.com/caddyserver/certmagic v0.24.0 // indirect
 	github.com/caddyserver/zerossl v0.1.3 // indirect
-	github.com/cespare/xxhash/v2 v2.3.0 // indirect
 	github.com/dolthub/maphash v0.1.0 // indirect
 	github.com/francoispqt/gojay v1.2.13 // indirect
 	github.com/gammazero/deque v1.1.0 // indirect
@@ -24,7 +25,6 @@ require (
 	github.com/mholt/acmez/v3 v3.1.2 // indirect
 	github.com/miekg/dns v1.1.68 // indirect
 	github.com/munnerz/goautoneg v0.0.0-20191010083416-a7dc8b61c822 // indirect
-	github.com/prometheus/client_golang v1.23.0 // indirect
 	github.com/prometheus/client_model v0.6.2 // indirect
 	github.com/prometheus/common v0.65.0 // indirect
 	github.com/prometheus/procfs v0.17.0 // indirect
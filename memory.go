@@ -0,0 +1,129 @@
+package franken_zstd
+
+//#include "zstd.h"
+import "C"
+import (
+	"fmt"
+	"sort"
+	"sync/atomic"
+	"time"
+
+	"github.com/klauspost/compress/zstd"
+)
+
+// Process-wide accounting of the memory held by compressor codecs. Every
+// encoder and decoder pair is charged an estimate of its window buffers when
+// built, and a window more as concurrent operations first need one, and
+// credited when closed or evicted. With a budget set, a charge that would
+// exceed it first evicts the least recently used idle compressors, and
+// fails when not enough can be evicted. Pooled encoders and
+// decoders of the quick functions are not charged: the garbage collector
+// already reclaims them when idle.
+var (
+	memoryBudget atomic.Int64 // 0 for no budget
+	memoryUsed   atomic.Int64
+	evictions    atomic.Int64
+
+	// Cap on the window and in-memory output of every decoder, 0 for the
+	// library default
+	decoderMaxMemory atomic.Int64
+)
+
+// codecFootprint estimates the memory of a set of codecs: a window buffer
+// per concurrent encode and per concurrent decode
+func codecFootprint(windowSize, encoders, decoders int) int64 {
+	return int64(encoders+decoders) << windowSize
+}
+
+// decoderLimits returns the decoder options enforcing the configured cap
+func decoderLimits() []zstd.DOption {
+	if limit := decoderMaxMemory.Load(); limit > 0 {
+		return []zstd.DOption{zstd.WithDecoderMaxMemory(uint64(limit))}
+	}
+	return nil
+}
+
+// reserveMemory charges n bytes to the budget, evicting idle compressors to
+// make room when needed
+func reserveMemory(n int64) error {
+	for {
+		budget, used := memoryBudget.Load(), memoryUsed.Load()
+		if budget > 0 && used+n > budget {
+			if n > budget {
+				return fmt.Errorf("compressor needs %d bytes, more than the memory budget of %d bytes", n, budget)
+			}
+			if evictLeastRecentlyUsed(used + n - budget) {
+				continue
+			}
+			return fmt.Errorf("memory budget exceeded: %d bytes needed, %d of %d bytes in use by active compressors", n, used, budget)
+		}
+		if memoryUsed.CompareAndSwap(used, used+n) {
+			return nil
+		}
+	}
+}
+
+func releaseMemory(n int64) {
+	memoryUsed.Add(-n)
+}
+
+// evictLeastRecentlyUsed evicts the codecs of idle compressors, least
+// recently used first, until at least need bytes are released, in a single
+// pass over the registry. It reports whether any was evicted.
+func evictLeastRecentlyUsed(need int64) bool {
+	var candidates []*Compressor
+	compressorRegistry.each(func(c *Compressor) {
+		if c.codecs.Load() != nil && c.refs.Load() == 1 {
+			candidates = append(candidates, c)
+		}
+	})
+	sort.Slice(candidates, func(i, j int) bool {
+		return candidates[i].lastUsed.Load() < candidates[j].lastUsed.Load()
+	})
+
+	var released int64
+	for _, c := range candidates {
+		if released >= need {
+			break
+		}
+		released += c.evict()
+	}
+	return released > 0
+}
+
+// evictIdle evicts the codecs of every compressor unused for timeout
+func evictIdle(timeout time.Duration) {
+	deadline := time.Now().Add(-timeout).UnixNano()
+	compressorRegistry.each(func(c *Compressor) {
+		if c.lastUsed.Load() < deadline && c.codecs.Load() != nil {
+			c.evict()
+		}
+	})
+}
+
+// startIdleEviction evicts idle codecs in the background until stop is
+// closed
+func startIdleEviction(timeout time.Duration, stop <-chan struct{}) {
+	ticker := time.NewTicker(max(timeout/2, time.Second))
+	go func() {
+		defer ticker.Stop()
+		for {
+			select {
+			case <-ticker.C:
+				evictIdle(timeout)
+			case <-stop:
+				return
+			}
+		}
+	}()
+}
+
+// Current memory accounting, for getMemoryUsage()
+//
+//export go_get_memory_usage
+func go_get_memory_usage(used, budget, evicted, decoderLimit *int64) {
+	*used = memoryUsed.Load()
+	*budget = memoryBudget.Load()
+	*evicted = evictions.Load()
+	*decoderLimit = decoderMaxMemory.Load()
+}
@@ -0,0 +1,179 @@
+package franken_zstd
+
+//#include "zstd.h"
+import "C"
+import (
+	"strconv"
+	"sync/atomic"
+	"time"
+	"unsafe"
+
+	"github.com/prometheus/client_golang/prometheus"
+)
+
+// Upper bounds of the latency histogram buckets, in seconds
+var latencyBuckets = [...]float64{
+	0.00001, 0.00005, 0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5,
+}
+
+// operationMetrics accumulates one kind of operation. Every field is updated
+// with atomics, so recording never contends with the codecs or with readers.
+type operationMetrics struct {
+	operations  atomic.Int64
+	errors      atomic.Int64
+	bytesIn     atomic.Int64
+	bytesOut    atomic.Int64
+	nanoseconds atomic.Int64
+	// Per-bucket counts; the last bucket counts everything above the bounds
+	latency [len(latencyBuckets) + 1]atomic.Int64
+}
+
+// record adds an operation that read in bytes and produced out bytes
+func (m *operationMetrics) record(in, out int, elapsed time.Duration, err error) {
+	if err != nil {
+		m.errors.Add(1)
+		return
+	}
+
+	m.operations.Add(1)
+	m.bytesIn.Add(int64(in))
+	m.bytesOut.Add(int64(out))
+	m.nanoseconds.Add(int64(elapsed))
+
+	seconds := elapsed.Seconds()
+	bucket := 0
+	for bucket < len(latencyBuckets) && seconds > latencyBuckets[bucket] {
+		bucket++
+	}
+	m.latency[bucket].Add(1)
+}
+
+// export copies the totals into the struct the C side reads
+func (m *operationMetrics) export(totals *C.franken_zstd_totals) {
+	totals.operations = C.int64_t(m.operations.Load())
+	totals.errors = C.int64_t(m.errors.Load())
+	totals.bytes_in = C.int64_t(m.bytesIn.Load())
+	totals.bytes_out = C.int64_t(m.bytesOut.Load())
+	totals.nanoseconds = C.int64_t(m.nanoseconds.Load())
+}
+
+// Process-wide metrics: compression per zstd level (index 0 unused), and
+// decompression, which has no level
+var processMetrics struct {
+	compress   [23]operationMetrics
+	decompress operationMetrics
+}
+
+func recordCompress(level, in, out int, elapsed time.Duration, err error) {
+	if level >= 1 && level <= 22 {
+		processMetrics.compress[level].record(in, out, elapsed, err)
+	}
+}
+
+func recordDecompress(in, out int, elapsed time.Duration, err error) {
+	processMetrics.decompress.record(in, out, elapsed, err)
+}
+
+// Copies the process-wide totals: compress must hold 22 entries, one per
+// level starting at level 1
+//
+//export go_get_metrics
+func go_get_metrics(compress *C.franken_zstd_totals, decompress *C.franken_zstd_totals) {
+	levels := unsafe.Slice(compress, 22)
+	for level := 1; level <= 22; level++ {
+		processMetrics.compress[level].export(&levels[level-1])
+	}
+	processMetrics.decompress.export(decompress)
+}
+
+// metricsCollector exposes the process-wide metrics to Prometheus. Values are
+// read from the atomics at scrape time, so nothing is kept twice.
+type metricsCollector struct {
+	operations *prometheus.Desc
+	errors     *prometheus.Desc
+	bytesIn    *prometheus.Desc
+	bytesOut   *prometheus.Desc
+	duration   *prometheus.Desc
+
+	memoryUsed   *prometheus.Desc
+	memoryBudget *prometheus.Desc
+	evictions    *prometheus.Desc
+
+	cacheHits   *prometheus.Desc
+	cacheMisses *prometheus.Desc
+	cacheSize   *prometheus.Desc
+}
+
+func newMetricsCollector() *metricsCollector {
+	labels := []string{"operation", "level"}
+	return &metricsCollector{
+		operations: prometheus.NewDesc("frankenphp_zstd_operations_total", "Completed zstd operations", labels, nil),
+		errors:     prometheus.NewDesc("frankenphp_zstd_errors_total", "Failed zstd operations", labels, nil),
+		bytesIn:    prometheus.NewDesc("frankenphp_zstd_bytes_in_total", "Bytes read by zstd operations", labels, nil),
+		bytesOut:   prometheus.NewDesc("frankenphp_zstd_bytes_out_total", "Bytes produced by zstd operations", labels, nil),
+		duration:   prometheus.NewDesc("frankenphp_zstd_duration_seconds", "Duration of zstd operations", labels, nil),
+
+		memoryUsed:   prometheus.NewDesc("frankenphp_zstd_memory_bytes", "Estimated memory held by compressor encoders and decoders", nil, nil),
+		memoryBudget: prometheus.NewDesc("frankenphp_zstd_memory_budget_bytes", "Memory budget of compressor encoders and decoders, 0 for none", nil, nil),
+		evictions:    prometheus.NewDesc("frankenphp_zstd_evictions_total", "Compressor encoders and decoders evicted to stay within the budget or when idle", nil, nil),
+
+		cacheHits:   prometheus.NewDesc("frankenphp_zstd_cache_hits_total", "Compressions answered from the result cache", nil, nil),
+		cacheMisses: prometheus.NewDesc("frankenphp_zstd_cache_misses_total", "Compressions looked up in the result cache and encoded", nil, nil),
+		cacheSize:   prometheus.NewDesc("frankenphp_zstd_cache_bytes", "Estimated memory held by the result cache", nil, nil),
+	}
+}
+
+func (c *metricsCollector) Describe(ch chan<- *prometheus.Desc) {
+	ch <- c.operations
+	ch <- c.errors
+	ch <- c.bytesIn
+	ch <- c.bytesOut
+	ch <- c.duration
+	ch <- c.memoryUsed
+	ch <- c.memoryBudget
+	ch <- c.evictions
+	ch <- c.cacheHits
+	ch <- c.cacheMisses
+	ch <- c.cacheSize
+}
+
+func (c *metricsCollector) Collect(ch chan<- prometheus.Metric) {
+	for level := 1; level <= 22; level++ {
+		c.collect(ch, &processMetrics.compress[level], "compress", strconv.Itoa(level))
+	}
+	c.collect(ch, &processMetrics.decompress, "decompress", "")
+
+	ch <- prometheus.MustNewConstMetric(c.memoryUsed, prometheus.GaugeValue, float64(memoryUsed.Load()))
+	ch <- prometheus.MustNewConstMetric(c.memoryBudget, prometheus.GaugeValue, float64(memoryBudget.Load()))
+	ch <- prometheus.MustNewConstMetric(c.evictions, prometheus.CounterValue, float64(evictions.Load()))
+
+	_, cacheSize := cacheUsage()
+	ch <- prometheus.MustNewConstMetric(c.cacheHits, prometheus.CounterValue, float64(resultCache.hits.Load()))
+	ch <- prometheus.MustNewConstMetric(c.cacheMisses, prometheus.CounterValue, float64(resultCache.misses.Load()))
+	ch <- prometheus.MustNewConstMetric(c.cacheSize, prometheus.GaugeValue, float64(cacheSize))
+}
+
+func (c *metricsCollector) collect(ch chan<- prometheus.Metric, m *operationMetrics, operation, level string) {
+	operations := m.operations.Load()
+	errors := m.errors.Load()
+	if operations == 0 && errors == 0 {
+		return // Keep unused levels out of the scrape
+	}
+
+	ch <- prometheus.MustNewConstMetric(c.operations, prometheus.CounterValue, float64(operations), operation, level)
+	ch <- prometheus.MustNewConstMetric(c.errors, prometheus.CounterValue, float64(errors), operation, level)
+	ch <- prometheus.MustNewConstMetric(c.bytesIn, prometheus.CounterValue, float64(m.bytesIn.Load()), operation, level)
+	ch <- prometheus.MustNewConstMetric(c.bytesOut, prometheus.CounterValue, float64(m.bytesOut.Load()), operation, level)
+
+	// Buckets are read one by one while operations may land, so the count is
+	// derived from them to keep the histogram consistent
+	buckets := make(map[float64]uint64, len(latencyBuckets))
+	var cumulative uint64
+	for i, bound := range latencyBuckets {
+		cumulative += uint64(m.latency[i].Load())
+		buckets[bound] = cumulative
+	}
+	cumulative += uint64(m.latency[len(latencyBuckets)].Load())
+	seconds := time.Duration(m.nanoseconds.Load()).Seconds()
+	ch <- prometheus.MustNewConstHistogram(c.duration, cumulative, seconds, buckets, operation, level)
+}
@@ -0,0 +1,95 @@
+package franken_zstd
+
+//#include <zend.h>
+import "C"
+import (
+	"strconv"
+	"strings"
+)
+
+// The output handler compresses a response on a stream compressor, one
+// output buffer chunk at a time, so a page is sent as it is generated
+// instead of being buffered whole. Its settings favor latency: level 3 and
+// a 1MB window keep each response's encoder small, well within the 8MB
+// window HTTP clients are required to accept (RFC 9659).
+const (
+	outputLevel      = 3
+	outputWindowSize = 20
+)
+
+// acceptsZstd reports whether an Accept-Encoding header allows zstd: listed
+// with a non-zero quality, or covered by "*" without being listed
+func acceptsZstd(header string) bool {
+	wildcard := false
+	for _, coding := range strings.Split(header, ",") {
+		name, params, _ := strings.Cut(coding, ";")
+		name = strings.TrimSpace(name)
+		switch {
+		case strings.EqualFold(name, "zstd"):
+			return nonZeroQuality(params)
+		case name == "*":
+			wildcard = nonZeroQuality(params)
+		}
+	}
+	return wildcard
+}
+
+// nonZeroQuality reports whether the parameters of a coding leave it
+// acceptable, a missing q meaning 1
+func nonZeroQuality(params string) bool {
+	for _, param := range strings.Split(params, ";") {
+		name, value, ok := strings.Cut(param, "=")
+		if ok && strings.EqualFold(strings.TrimSpace(name), "q") {
+			q, err := strconv.ParseFloat(strings.TrimSpace(value), 64)
+			return err == nil && q > 0
+		}
+	}
+	return true
+}
+
+//export go_output_accepts_zstd
+func go_output_accepts_zstd(header *C.char, headerLen C.size_t) bool {
+	return acceptsZstd(string(cBytes(header, headerLen)))
+}
+
+// Starts the stream of an output handler
+//
+//export go_output_start
+func go_output_start(handle *C.uint64_t) *C.char {
+	return go_stream_compressor_create(outputLevel, outputWindowSize, 0, handle)
+}
+
+// Compresses an output buffer chunk, ending the block on a flush of the
+// buffer and the frame when the buffer is closed
+//
+//export go_output_write
+func go_output_write(handle C.uint64_t, data *C.char, dataLen C.size_t, flush, finish bool, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	stream, err := streamCompressorRegistry.lookup(uint64(handle))
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	out, err := stream.WriteEnd(cBytes(data, dataLen), flush, finish)
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	storeResult(nil, out, resultLen, pending)
+}
+
+// Discards the frame of an output handler after its buffer was cleaned, so
+// the output that follows starts a new frame
+//
+//export go_output_reset
+func go_output_reset(handle C.uint64_t) *C.char {
+	stream, err := streamCompressorRegistry.lookup(uint64(handle))
+	if err != nil {
+		return C.CString(err.Error())
+	}
+	if err := stream.Reset(); err != nil {
+		return C.CString(err.Error())
+	}
+	return nil // Success
+}
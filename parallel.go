@@ -0,0 +1,58 @@
+package franken_zstd
+
+import (
+	"github.com/klauspost/compress/zstd"
+)
+
+// Smallest input slice worth a frame of its own. Below this, the frame
+// overhead and the matches lost at the frame boundary outweigh the speedup.
+const parallelMinSegment = 1 << 20
+
+// compressParallel splits data into up to threads segments and compresses
+// each into an independent frame concurrently. Concatenated frames are a
+// standard zstd stream that any decoder reads back as a single payload.
+func compressParallel(encoder *zstd.Encoder, data, dst []byte, threads int) []byte {
+	segmentSize := (len(data) + threads - 1) / threads
+	if segmentSize < parallelMinSegment {
+		segmentSize = parallelMinSegment
+	}
+
+	compressed, _ := compressSegments(data, dst, segmentSize, encoder.EncodeAll)
+	return compressed
+}
+
+// compressSegments compresses each segmentSize slice of data into its own
+// frame concurrently and returns the frames concatenated in order, along
+// with the compressed size of each. The first frame is written straight into
+// dst; the others are compressed into their own buffers and appended.
+func compressSegments(data, dst []byte, segmentSize int, compress func(segment, dst []byte) []byte) ([]byte, []int) {
+	count := (len(data) + segmentSize - 1) / segmentSize
+
+	frames := make([][]byte, count)
+	parallelEach(count, func(i int) {
+		segment := data[i*segmentSize : min((i+1)*segmentSize, len(data))]
+		if i == 0 {
+			frames[i] = compress(segment, dst)
+			return
+		}
+		frames[i] = compress(segment, make([]byte, 0, compressBound(len(segment))))
+	})
+
+	if count == 0 {
+		return dst, nil
+	}
+
+	sizes := make([]int, count)
+	sizes[0] = len(frames[0]) - len(dst)
+	compressed := frames[0]
+	for i, frame := range frames[1:] {
+		sizes[i+1] = len(frame)
+		compressed = append(compressed, frame...)
+	}
+	return compressed, sizes
+}
+
+// compressBound mirrors FRANKEN_ZSTD_COMPRESS_BOUND on the C side
+func compressBound(n int) int {
+	return n + n>>8 + 64
+}
@@ -0,0 +1,71 @@
+package franken_zstd
+
+//#include <zend.h>
+import "C"
+import (
+	"fmt"
+	"sync"
+)
+
+// Named compressors that live for the lifetime of the process. In worker
+// mode a request looks its compressor up by name instead of building a new
+// encoder and decoder, and every thread shares the same instance. Lookups
+// are lock-free; only the first creation of a name is serialized.
+var (
+	persistentCompressors   sync.Map // string -> *persistentCompressor
+	persistentCompressorsMu sync.Mutex
+)
+
+type persistentCompressor struct {
+	handle     uint64
+	compressor *Compressor
+}
+
+// PersistentCompressor returns the registry handle of the compressor named
+// name, creating it with the given settings on first use. Asking for an
+// existing name with other settings fails rather than handing out a
+// compressor configured differently than requested.
+func PersistentCompressor(name string, level, windowSize int, dictID uint32, threads int) (uint64, error) {
+	if entry, ok := persistentCompressors.Load(name); ok {
+		return entry.(*persistentCompressor).match(name, level, windowSize, dictID, threads)
+	}
+
+	persistentCompressorsMu.Lock()
+	defer persistentCompressorsMu.Unlock()
+
+	if entry, ok := persistentCompressors.Load(name); ok {
+		return entry.(*persistentCompressor).match(name, level, windowSize, dictID, threads)
+	}
+
+	compressor, err := NewCompressor(level, windowSize, dictID, threads)
+	if err != nil {
+		return 0, err
+	}
+	handle, err := compressorRegistry.register(compressor)
+	if err != nil {
+		compressor.Close()
+		return 0, err
+	}
+
+	persistentCompressors.Store(name, &persistentCompressor{handle: handle, compressor: compressor})
+	return handle, nil
+}
+
+func (p *persistentCompressor) match(name string, level, windowSize int, dictID uint32, threads int) (uint64, error) {
+	c := p.compressor
+	if c.level != level || c.windowSize != windowSize || c.dictID != dictID || c.threads != threads {
+		return 0, fmt.Errorf("persistent compressor %q already exists with level %d, window size %d, dictionary %d and %d threads", name, c.level, c.windowSize, c.dictID, c.threads)
+	}
+	return p.handle, nil
+}
+
+//export go_compressor_persistent
+func go_compressor_persistent(name *C.zend_string, level, windowSize, dictID, threads int64, handle *C.uint64_t) *C.char {
+	h, err := PersistentCompressor(string(zendStringBytes(name)), int(level), int(windowSize), uint32(dictID), int(threads))
+	if err != nil {
+		return C.CString(err.Error())
+	}
+
+	*handle = C.uint64_t(h)
+	return nil // Success
+}
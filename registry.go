@@ -0,0 +1,126 @@
+package franken_zstd
+
+import (
+	"errors"
+	"sync"
+	"sync/atomic"
+)
+
+// Compressors and streams are addressed by integer handles that the C side
+// stores in its objects. A handle packs a slot index with the generation of the
+// slot, so a handle kept after close() never resolves to a compressor that
+// reused the slot.
+//
+// Slots live in fixed-size pages that are never moved once published, which
+// keeps lookups lock-free: a page pointer load, a slot pointer load and a
+// generation check. Only register and unregister take the registry mutex.
+const (
+	registryPageBits = 10
+	registryPageSize = 1 << registryPageBits
+	registryMaxPages = 1 << 12
+)
+
+type registrySlot[T any] struct {
+	generation uint32
+	value      *T
+}
+
+type registryPage[T any] [registryPageSize]atomic.Pointer[registrySlot[T]]
+
+type handleRegistry[T any] struct {
+	pages      [registryMaxPages]atomic.Pointer[registryPage[T]]
+	mu         sync.Mutex
+	next       uint32
+	free       []uint32
+	generation []uint32
+	notFound   error
+}
+
+var compressorRegistry = handleRegistry[Compressor]{notFound: errors.New("compressor not found")}
+
+// register stores value and returns its handle. Handles are never 0, so the
+// C side can use 0 for a closed object.
+func (r *handleRegistry[T]) register(value *T) (uint64, error) {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+
+	var index uint32
+	if n := len(r.free); n > 0 {
+		index = r.free[n-1]
+		r.free = r.free[:n-1]
+	} else {
+		if r.next >= registryPageSize*registryMaxPages {
+			return 0, errors.New("too many open handles")
+		}
+		index = r.next
+		r.next++
+		r.generation = append(r.generation, 0)
+		if index%registryPageSize == 0 {
+			r.pages[index>>registryPageBits].Store(new(registryPage[T]))
+		}
+	}
+
+	r.generation[index]++
+	if r.generation[index] == 0 {
+		r.generation[index] = 1
+	}
+	generation := r.generation[index]
+	r.slot(index).Store(&registrySlot[T]{generation: generation, value: value})
+
+	return uint64(generation)<<32 | uint64(index), nil
+}
+
+// lookup resolves a handle without taking any lock
+func (r *handleRegistry[T]) lookup(handle uint64) (*T, error) {
+	index, generation := uint32(handle), uint32(handle>>32)
+	if generation == 0 || index>>registryPageBits >= registryMaxPages {
+		return nil, r.notFound
+	}
+
+	page := r.pages[index>>registryPageBits].Load()
+	if page == nil {
+		return nil, r.notFound
+	}
+
+	slot := page[index%registryPageSize].Load()
+	if slot == nil || slot.generation != generation {
+		return nil, r.notFound
+	}
+	return slot.value, nil
+}
+
+// unregister removes the value behind handle and returns it
+func (r *handleRegistry[T]) unregister(handle uint64) (*T, error) {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+
+	value, err := r.lookup(handle)
+	if err != nil {
+		return nil, err
+	}
+
+	index := uint32(handle)
+	r.slot(index).Store(nil)
+	r.free = append(r.free, index)
+	return value, nil
+}
+
+// each calls fn with every registered value without taking any lock. Values
+// registered or unregistered meanwhile may or may not be visited.
+func (r *handleRegistry[T]) each(fn func(*T)) {
+	for i := range r.pages {
+		page := r.pages[i].Load()
+		if page == nil {
+			return // Pages are published in order
+		}
+		for j := range page {
+			if slot := page[j].Load(); slot != nil {
+				fn(slot.value)
+			}
+		}
+	}
+}
+
+func (r *handleRegistry[T]) slot(index uint32) *atomic.Pointer[registrySlot[T]] {
+	return &r.pages[index>>registryPageBits].Load()[index%registryPageSize]
+}
@@ -0,0 +1,261 @@
+package franken_zstd
+
+//#include <zend.h>
+import "C"
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"sort"
+	"time"
+
+	"github.com/klauspost/compress/zstd"
+)
+
+// Seekable format, as specified by zstd's contrib/seekable_format: a sequence
+// of independent frames followed by a skippable frame holding a seek table.
+// Each table entry records the compressed and decompressed size of a frame,
+// so a range of the content maps to the frames covering it without decoding
+// the others. Decoders unaware of the format skip the table and read the
+// frames as one payload.
+const (
+	seekTableMagic      = 0x184D2A5E // Skippable frame magic used for the seek table
+	seekableMagic       = 0x8F92EAB1
+	seekTableFooterSize = 9
+	seekableMaxFrames   = 0x8000000
+	seekableMaxFrame    = 1 << 30
+)
+
+var errNotSeekable = errors.New("not a seekable zstd payload")
+
+// seekEntry locates one frame in both the compressed and decompressed data
+type seekEntry struct {
+	compressedOffset   int
+	compressedSize     int
+	decompressedOffset int64
+	decompressedSize   int
+}
+
+// CompressSeekable compresses data into frames of frameSize decompressed
+// bytes, in parallel, and appends the seek table
+func CompressSeekable(data, dst []byte, level, frameSize int) ([]byte, error) {
+	if level < 1 || level > 22 {
+		return nil, fmt.Errorf("invalid compression level: %d (must be 1-22)", level)
+	}
+	if frameSize < 1<<10 || frameSize > seekableMaxFrame {
+		return nil, fmt.Errorf("invalid frame size: %d (must be 1024-%d)", frameSize, seekableMaxFrame)
+	}
+	if (len(data)+frameSize-1)/frameSize > seekableMaxFrames {
+		return nil, fmt.Errorf("too many frames: use a frame size of at least %d", len(data)/seekableMaxFrames+1)
+	}
+
+	encoderLevel := zstd.EncoderLevelFromZstd(level)
+	compressed, sizes := compressSegments(data, dst, frameSize, func(segment, dst []byte) []byte {
+		encoder := getEncoder(encoderLevel)
+		defer putEncoder(encoderLevel, encoder)
+		return encoder.EncodeAll(segment, dst)
+	})
+
+	compressed = binary.LittleEndian.AppendUint32(compressed, seekTableMagic)
+	compressed = binary.LittleEndian.AppendUint32(compressed, uint32(len(sizes)*8+seekTableFooterSize))
+	for i, size := range sizes {
+		compressed = binary.LittleEndian.AppendUint32(compressed, uint32(size))
+		compressed = binary.LittleEndian.AppendUint32(compressed, uint32(min(frameSize, len(data)-i*frameSize)))
+	}
+	compressed = binary.LittleEndian.AppendUint32(compressed, uint32(len(sizes)))
+	compressed = append(compressed, 0) // Descriptor: no checksums
+	compressed = binary.LittleEndian.AppendUint32(compressed, seekableMagic)
+
+	return compressed, nil
+}
+
+// readSeekTable parses the seek table at the end of data. Tables written
+// with per-frame checksums are accepted; the checksums are not verified, as
+// every frame carries its own. A frame recorded with more content than a
+// zstd frame of its compressed size can hold is rejected.
+func readSeekTable(data []byte) ([]seekEntry, error) {
+	if len(data) < 8+seekTableFooterSize {
+		return nil, errNotSeekable
+	}
+	footer := data[len(data)-seekTableFooterSize:]
+	if binary.LittleEndian.Uint32(footer[5:]) != seekableMagic {
+		return nil, errNotSeekable
+	}
+
+	count := int(binary.LittleEndian.Uint32(footer))
+	descriptor := footer[4]
+	if descriptor&0x7C != 0 || count > seekableMaxFrames {
+		return nil, errors.New("invalid seek table")
+	}
+	entrySize := 8
+	if descriptor&0x80 != 0 {
+		entrySize = 12
+	}
+
+	tableSize := count*entrySize + seekTableFooterSize
+	if 8+tableSize > len(data) {
+		return nil, errors.New("truncated seek table")
+	}
+	start := len(data) - 8 - tableSize
+	if binary.LittleEndian.Uint32(data[start:]) != seekTableMagic || int(binary.LittleEndian.Uint32(data[start+4:])) != tableSize {
+		return nil, errors.New("invalid seek table")
+	}
+
+	entries := make([]seekEntry, count)
+	table := data[start+8:]
+	compressedOffset, decompressedOffset := 0, int64(0)
+	for i := range entries {
+		entry := table[i*entrySize:]
+		entries[i] = seekEntry{
+			compressedOffset:   compressedOffset,
+			compressedSize:     int(binary.LittleEndian.Uint32(entry)),
+			decompressedOffset: decompressedOffset,
+			decompressedSize:   int(binary.LittleEndian.Uint32(entry[4:])),
+		}
+		compressedOffset += entries[i].compressedSize
+		decompressedOffset += int64(entries[i].decompressedSize)
+		if compressedOffset > start || int64(entries[i].decompressedSize) > int64(entries[i].compressedSize)*maxFrameRatio {
+			return nil, errors.New("seek table does not match the frames")
+		}
+	}
+	if compressedOffset != start {
+		return nil, errors.New("seek table does not match the frames")
+	}
+
+	return entries, nil
+}
+
+// seekableSize returns the decompressed size recorded by the seek table
+func seekableSize(entries []seekEntry) int64 {
+	if len(entries) == 0 {
+		return 0
+	}
+	last := entries[len(entries)-1]
+	return last.decompressedOffset + int64(last.decompressedSize)
+}
+
+// DecompressRange decodes length bytes of the content starting at offset,
+// clamped to the end of the content, decoding only the frames covering the
+// range. Frames are decoded in parallel; those entirely inside the range are
+// decoded straight into their place in the output.
+func DecompressRange(data, dst []byte, offset, length int64) ([]byte, error) {
+	startTime := time.Now()
+	out, in, err := decompressRange(data, dst, offset, length)
+	recordDecompress(in, len(out), time.Since(startTime), err)
+	return out, err
+}
+
+// decompressRange implements DecompressRange, also returning the compressed
+// size of the frames it decoded
+func decompressRange(data, dst []byte, offset, length int64) ([]byte, int, error) {
+	entries, err := readSeekTable(data)
+	if err != nil {
+		return nil, 0, err
+	}
+
+	size := seekableSize(entries)
+	if offset < 0 || length < 0 || offset > size {
+		return nil, 0, fmt.Errorf("invalid range: offset %d, length %d (content size is %d)", offset, length, size)
+	}
+	end := offset + min(length, size-offset)
+	if end == offset {
+		return dst[:0], 0, nil
+	}
+
+	out := dst[:0]
+	if cap(out) < int(end-offset) {
+		out = make([]byte, 0, end-offset)
+	}
+	out = out[:end-offset]
+
+	first := sort.Search(len(entries), func(i int) bool {
+		return entries[i].decompressedOffset+int64(entries[i].decompressedSize) > offset
+	})
+	last := sort.Search(len(entries), func(i int) bool {
+		return entries[i].decompressedOffset >= end
+	})
+
+	compressedSize := 0
+	for _, entry := range entries[first:last] {
+		compressedSize += entry.compressedSize
+	}
+
+	errs := make([]error, last-first)
+	parallelEach(last-first, func(i int) {
+		entry := entries[first+i]
+		frame := data[entry.compressedOffset : entry.compressedOffset+entry.compressedSize]
+		frameEnd := entry.decompressedOffset + int64(entry.decompressedSize)
+		lo, hi := max(offset, entry.decompressedOffset), min(end, frameEnd)
+		target := out[lo-offset : hi-offset]
+
+		if lo == entry.decompressedOffset && hi == frameEnd {
+			decoded, err := quickDecompress(frame, target[:0:len(target)])
+			if err != nil {
+				errs[i] = err
+			} else if len(decoded) != len(target) {
+				errs[i] = errors.New("seek table does not match the frames")
+			} else if len(decoded) > 0 && &decoded[0] != &target[0] {
+				copy(target, decoded)
+			}
+			return
+		}
+
+		// Sized by the frame header rather than by the table
+		decoded, err := quickDecompress(frame, nil)
+		if err != nil {
+			errs[i] = err
+			return
+		}
+		if len(decoded) != entry.decompressedSize {
+			errs[i] = errors.New("seek table does not match the frames")
+			return
+		}
+		copy(target, decoded[lo-entry.decompressedOffset:])
+	})
+
+	if err := errors.Join(errs...); err != nil {
+		return nil, compressedSize, err
+	}
+	return out, compressedSize, nil
+}
+
+// Seekable compression with the pooled encoders of a level
+//
+//export go_compress_seekable
+func go_compress_seekable(data *C.zend_string, level, frameSize int64, result *C.zend_string, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	buf := zendStringBuffer(result)
+	input := zendStringBytes(data)
+	startTime := time.Now()
+	compressed, err := CompressSeekable(input, buf, int(level), int(frameSize))
+	recordCompress(int(level), len(input), len(compressed), time.Since(startTime), err)
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	storeResult(buf, compressed, resultLen, pending)
+}
+
+// Decompressed size recorded by the seek table of a payload, used by the C
+// side to size the output of a range. Returns -1 when data is not seekable.
+//
+//export go_seekable_size
+func go_seekable_size(data *C.zend_string) int64 {
+	entries, err := readSeekTable(zendStringBytes(data))
+	if err != nil {
+		return -1
+	}
+	return seekableSize(entries)
+}
+
+//export go_decompress_range
+func go_decompress_range(data *C.zend_string, offset, length int64, result *C.zend_string, resultLen *C.size_t, pending *C.uintptr_t, error **C.char) {
+	buf := zendStringBuffer(result)
+	decompressed, err := DecompressRange(zendStringBytes(data), buf, offset, length)
+	if err != nil {
+		*error = C.CString(err.Error())
+		return
+	}
+
+	storeResult(buf, decompressed, resultLen, pending)
+}
@@ -0,0 +1,387 @@
+package franken_zstd
+
+import (
+	"bytes"
+	"errors"
+	"fmt"
+	"io"
+	"sync"
+
+	"github.com/klauspost/compress/zstd"
+)
+
+// Size of the chunks a stream decompressor reads from its decoder
+const streamChunkSize = 64 << 10
+
+var (
+	streamCompressorRegistry   = handleRegistry[StreamCompressor]{notFound: errors.New("stream compressor not found")}
+	streamDecompressorRegistry = handleRegistry[StreamDecompressor]{notFound: errors.New("stream decompressor not found")}
+
+	errStreamFinished = errors.New("stream already finished")
+)
+
+// StreamCompressor compresses a payload incrementally. Each call returns the
+// compressed bytes produced so far, so memory is bounded by the window and
+// block buffers of the encoder rather than by the payload size.
+type StreamCompressor struct {
+	encoder  *zstd.Encoder
+	sink     bytes.Buffer
+	finished bool
+	mutex    sync.Mutex
+}
+
+// NewStreamCompressor creates a stream compressor, optionally bound to a
+// registered dictionary (dictID 0 for none)
+func NewStreamCompressor(level, windowSize int, dictID uint32) (*StreamCompressor, error) {
+	if level < 1 || level > 22 {
+		return nil, fmt.Errorf("invalid compression level: %d (must be 1-22)", level)
+	}
+	if windowSize < 10 || windowSize > 31 {
+		return nil, fmt.Errorf("invalid window size: %d (must be 10-31)", windowSize)
+	}
+
+	encoderOptions, _, err := codecOptions(level, windowSize, dictID)
+	if err != nil {
+		return nil, err
+	}
+
+	// A single encoder goroutine keeps Write synchronous, so everything it
+	// produces is in the sink when Write returns
+	s := &StreamCompressor{}
+	s.encoder, err = zstd.NewWriter(&s.sink, append(encoderOptions, zstd.WithEncoderConcurrency(1))...)
+	if err != nil {
+		return nil, fmt.Errorf("failed to create encoder: %w", err)
+	}
+
+	return s, nil
+}
+
+// Write compresses data and returns the compressed bytes produced by it. The
+// returned slice is only valid until the next call on the stream.
+func (s *StreamCompressor) Write(data []byte) ([]byte, error) {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+
+	if s.finished {
+		return nil, errStreamFinished
+	}
+	if _, err := s.encoder.Write(data); err != nil {
+		return nil, err
+	}
+	return s.take(), nil
+}
+
+// Flush ends the current block, so everything written so far can be
+// decompressed by the receiver
+func (s *StreamCompressor) Flush() ([]byte, error) {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+
+	if s.finished {
+		return nil, errStreamFinished
+	}
+	if err := s.encoder.Flush(); err != nil {
+		return nil, err
+	}
+	return s.take(), nil
+}
+
+// Finish ends the frame and returns its remaining bytes
+func (s *StreamCompressor) Finish() ([]byte, error) {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+
+	if s.finished {
+		return nil, errStreamFinished
+	}
+	s.finished = true
+	if err := s.encoder.Close(); err != nil {
+		return nil, err
+	}
+	return s.take(), nil
+}
+
+// WriteEnd compresses data, then ends the block when flush is set or the
+// frame when finish is set, and returns everything produced in one piece
+func (s *StreamCompressor) WriteEnd(data []byte, flush, finish bool) ([]byte, error) {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+
+	if s.finished {
+		return nil, errStreamFinished
+	}
+	if _, err := s.encoder.Write(data); err != nil {
+		return nil, err
+	}
+
+	var err error
+	switch {
+	case finish:
+		s.finished = true
+		err = s.encoder.Close()
+	case flush:
+		err = s.encoder.Flush()
+	}
+	if err != nil {
+		return nil, err
+	}
+	return s.take(), nil
+}
+
+// Reset discards the frame in progress, including any input the encoder
+// still buffers, and starts a new one
+func (s *StreamCompressor) Reset() error {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+
+	if s.finished {
+		return errStreamFinished
+	}
+	s.encoder.Reset(&s.sink)
+	s.sink.Reset()
+	return nil
+}
+
+// Close releases the encoder without finishing the frame
+func (s *StreamCompressor) Close() {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+
+	if !s.finished {
+		s.finished = true
+		s.encoder.Reset(io.Discard)
+		s.encoder.Close()
+	}
+	s.sink = bytes.Buffer{}
+}
+
+// take hands out the sink contents; the C side copies them before the next
+// call can write into the sink again
+func (s *StreamCompressor) take() []byte {
+	out := s.sink.Bytes()
+	s.sink.Reset()
+	return out
+}
+
+// StreamDecompressor decompresses a payload pushed to it in chunks. The
+// streaming decoder pulls its input, so it runs on its own goroutine and
+// reads from a streamSource that PHP feeds one chunk at a time. Between
+// calls, the goroutine is parked either waiting for input or, when a call
+// capped its output, waiting to hand over its next decoded chunk. Either
+// way it holds only the window, one decoded chunk and the compressed input
+// it was not fed yet, so a highly compressible chunk never expands in
+// memory beyond what a caller asks for.
+type StreamDecompressor struct {
+	input    chan []byte
+	events   chan streamEvent
+	queue    [][]byte // Input written but not yet fed to the decoder
+	pending  []byte   // Decoded output not yet returned
+	waiting  bool     // The decoder is waiting for input
+	closed   bool     // The input channel is closed
+	finished bool
+	stopped  bool
+	err      error
+	mutex    sync.Mutex
+}
+
+// streamEvent is either decoded output, a request for more input, or the
+// terminal error of the decoder (io.EOF at the end of a complete stream)
+type streamEvent struct {
+	data      []byte
+	needInput bool
+	err       error
+}
+
+// streamSource feeds PHP chunks to the decoder, announcing each time it runs
+// dry. The decoder only asks for more input once it has returned all output
+// it could decode, so that announcement marks the end of a Write.
+type streamSource struct {
+	input  <-chan []byte
+	events chan<- streamEvent
+	chunk  []byte
+}
+
+func (s *streamSource) Read(p []byte) (int, error) {
+	for len(s.chunk) == 0 {
+		s.events <- streamEvent{needInput: true}
+		chunk, ok := <-s.input
+		if !ok {
+			return 0, io.EOF
+		}
+		s.chunk = chunk
+	}
+	n := copy(p, s.chunk)
+	s.chunk = s.chunk[n:]
+	return n, nil
+}
+
+// NewStreamDecompressor creates a stream decompressor accepting windows of
+// up to 1<<maxWindowSize bytes. Every registered dictionary is available to it.
+func NewStreamDecompressor(maxWindowSize int) (*StreamDecompressor, error) {
+	if maxWindowSize < 10 || maxWindowSize > 31 {
+		return nil, fmt.Errorf("invalid window size: %d (must be 10-31)", maxWindowSize)
+	}
+
+	s := &StreamDecompressor{
+		input:  make(chan []byte),
+		events: make(chan streamEvent),
+	}
+	source := &streamSource{input: s.input, events: s.events}
+
+	decoder, err := zstd.NewReader(nil, append(decoderLimits(),
+		zstd.WithDecoderConcurrency(1),
+		zstd.WithDecoderMaxWindow(1<<maxWindowSize),
+		zstd.WithDecoderDicts(registeredDictionaries()...))...)
+	if err != nil {
+		return nil, fmt.Errorf("failed to create decoder: %w", err)
+	}
+
+	go func() {
+		defer decoder.Close()
+		if err := decoder.Reset(source); err != nil {
+			s.events <- streamEvent{err: err}
+			return
+		}
+		for {
+			buf := make([]byte, streamChunkSize)
+			n, err := decoder.Read(buf)
+			if n > 0 {
+				s.events <- streamEvent{data: buf[:n]}
+			}
+			if err != nil {
+				s.events <- streamEvent{err: err}
+				return
+			}
+		}
+	}()
+
+	// Wait for the decoder to ask for its first chunk
+	if _, err := s.collect(0); err != nil {
+		return nil, err
+	}
+
+	return s, nil
+}
+
+// Write feeds a chunk of compressed data and returns the output decoded so
+// far, at most maxLength bytes of it (0 for no limit). The rest stays in the
+// decoder until the next call.
+func (s *StreamDecompressor) Write(data []byte, maxLength int) ([]byte, error) {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+
+	if s.finished {
+		return nil, errStreamFinished
+	}
+	if len(data) > 0 {
+		// The chunk outlives this call, so it cannot alias the PHP string
+		s.queue = append(s.queue, bytes.Clone(data))
+	}
+	return s.collect(maxLength)
+}
+
+// Read returns up to maxLength bytes (0 for no limit) of the output left
+// over by a capped call, decoding further input already written. It returns
+// nothing once the decoder needs more input.
+func (s *StreamDecompressor) Read(maxLength int) ([]byte, error) {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+
+	return s.collect(maxLength)
+}
+
+// Finish signals the end of input and returns the remaining output, at most
+// maxLength bytes of it (0 for no limit); Read returns the rest. It fails
+// when the input ended in the middle of a frame.
+func (s *StreamDecompressor) Finish(maxLength int) ([]byte, error) {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+
+	if s.finished {
+		return nil, errStreamFinished
+	}
+	s.finished = true
+	return s.collect(maxLength)
+}
+
+// Close stops the decoder goroutine without checking for a complete stream,
+// discarding the output left
+func (s *StreamDecompressor) Close() {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+
+	s.finished = true
+	s.queue = nil
+	for !s.stopped {
+		s.pending = nil
+		s.collect(streamChunkSize)
+	}
+}
+
+// collect returns pending output, then feeds queued input to the decoder and
+// gathers its output until maxLength bytes (0 for no limit), until the
+// decoder needs input nobody wrote yet, or until it stops. Output past
+// maxLength stays pending.
+func (s *StreamDecompressor) collect(maxLength int) ([]byte, error) {
+	out := s.take(nil, maxLength)
+	for !s.stopped && (maxLength <= 0 || len(out) < maxLength) {
+		if s.waiting && !s.feed() {
+			break
+		}
+
+		event := <-s.events
+		switch {
+		case event.needInput:
+			s.waiting = true
+		case event.err == io.EOF:
+			s.stopped = true
+		case event.err != nil:
+			s.stopped = true
+			s.err = fmt.Errorf("decompression failed: %w", event.err)
+		default:
+			s.pending = event.data
+			out = s.take(out, maxLength)
+		}
+	}
+
+	if s.err != nil {
+		return nil, s.err
+	}
+	return out, nil
+}
+
+// feed hands the decoder its next queued chunk, or the end of input once
+// the stream is finished, reporting whether the decoder can go on
+func (s *StreamDecompressor) feed() bool {
+	switch {
+	case len(s.queue) > 0:
+		s.input <- s.queue[0]
+		s.queue[0] = nil
+		s.queue = s.queue[1:]
+	case s.finished:
+		// Past the end of input the decoder asks again before stopping
+		if !s.closed {
+			close(s.input)
+			s.closed = true
+		}
+	default:
+		return false
+	}
+	s.waiting = false
+	return true
+}
+
+// take moves pending output to out, keeping out within maxLength bytes
+func (s *StreamDecompressor) take(out []byte, maxLength int) []byte {
+	n := len(s.pending)
+	if maxLength > 0 {
+		n = min(n, maxLength-len(out))
+	}
+	if out == nil && n == len(s.pending) {
+		out = s.pending
+	} else {
+		out = append(out, s.pending[:n]...)
+	}
+	s.pending = s.pending[n:]
+	return out
+}
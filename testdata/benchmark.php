@@ -137,6 +137,196 @@ foreach ($testData as $sizeName => $data) {
            $sizeName, "Decompress", $decompressionTime, $speed);
 }
 
+echo "\nPooled Encoder Test\n";
+echo "-------------------\n";
+printf("%-8s %-10s %-14s %-14s %-14s %-14s\n", "Size", "Level", "Fresh(ms)", "Reused(ms)", "Build(ms)", "Pooled(ms)");
+echo str_repeat("-", 78) . "\n";
+
+// Fresh builds a compressor for every call, Reused encodes with one built
+// up front; both use the level and window of the pooled encoders (4MB for
+// the fastest level, 8MB otherwise), so Build = Fresh - Reused is what
+// constructing codecs costs a call. Pooled is the quick function reusing
+// pooled encoders. Every input is distinct, so the result cache never hits.
+$iterations = 50;
+foreach (['1KB', '100KB'] as $sizeName) {
+    $inputs = [];
+    for ($i = 0; $i < $iterations; $i++) {
+        $inputs[] = $i . $testData[$sizeName];
+    }
+
+    foreach ($levels + ['Ultra' => Compressor::LEVEL_ULTRA] as $levelName => $level) {
+        $windowSize = $level === Compressor::LEVEL_FASTEST ? 22 : 23;
+        \Phillarmonic\FrankenZstd\compress($testData[$sizeName], $level); // Warm up the pool
+
+        $startTime = microtime(true);
+        foreach ($inputs as $input) {
+            $compressor = Compressor::create($level, $windowSize);
+            $compressor->compress($input);
+            $compressor->close();
+        }
+        $freshTime = (microtime(true) - $startTime) * 1000 / $iterations;
+
+        $compressor = Compressor::create($level, $windowSize);
+        $compressor->compress($testData[$sizeName]); // First use allocates the encoder state
+        $startTime = microtime(true);
+        foreach ($inputs as $input) {
+            $compressor->compress($input);
+        }
+        $reusedTime = (microtime(true) - $startTime) * 1000 / $iterations;
+        $compressor->close();
+
+        $startTime = microtime(true);
+        foreach ($inputs as $input) {
+            \Phillarmonic\FrankenZstd\compress($input, $level);
+        }
+        $pooledTime = (microtime(true) - $startTime) * 1000 / $iterations;
+
+        printf("%-8s %-10s %-14.3f %-14.3f %-14.3f %-14.3f\n",
+               $sizeName, $levelName, $freshTime, $reusedTime, $freshTime - $reusedTime, $pooledTime);
+    }
+}
+
+echo "\nBoundary Copy Test\n";
+echo "------------------\n";
+printf("%-8s %-12s %-18s %-18s\n", "Size", "Operation", "Est. before(B)", "Copied now(B)");
+echo str_repeat("-", 60) . "\n";
+
+// The old path can no longer be run, so its column is an estimate: every
+// call copied the input into Go, the output into a malloc'd buffer and that
+// buffer into a zend_string. The current column is measured, including
+// outputs moved when their buffer is shrunk.
+foreach ($testData as $sizeName => $data) {
+    $originalSize = strlen($data);
+
+    $copiedBefore = \Phillarmonic\FrankenZstd\getInfo()['bytesCopied'];
+    $compressed = \Phillarmonic\FrankenZstd\compress($data);
+    $copiedAfter = \Phillarmonic\FrankenZstd\getInfo()['bytesCopied'];
+
+    printf("%-8s %-12s %-18d %-18d\n",
+           $sizeName, "Compress", $originalSize + 2 * strlen($compressed), $copiedAfter - $copiedBefore);
+
+    $copiedBefore = $copiedAfter;
+    \Phillarmonic\FrankenZstd\decompress($compressed);
+    $copiedAfter = \Phillarmonic\FrankenZstd\getInfo()['bytesCopied'];
+
+    printf("%-8s %-12s %-18d %-18d\n",
+           $sizeName, "Decompress", strlen($compressed) + 2 * $originalSize, $copiedAfter - $copiedBefore);
+}
+
+echo "\nBatch Test\n";
+echo "----------\n";
+printf("%-8s %-8s %-14s %-14s %-10s\n", "Size", "Items", "Loop(ms)", "Batch(ms)", "Speedup");
+echo str_repeat("-", 58) . "\n";
+
+foreach (['1KB' => 1024, '10KB' => 10240, '100KB' => 102400] as $sizeName => $size) {
+    $count = $size >= 102400 ? 64 : 512;
+    $items = [];
+    for ($i = 0; $i < $count; $i++) {
+        $items["entry:$i"] = substr(str_repeat("cache entry $i payload ", intdiv($size, 20) + 1), 0, $size);
+    }
+
+    $start = microtime(true);
+    foreach ($items as $key => $item) {
+        \Phillarmonic\FrankenZstd\compress($item);
+    }
+    $loopTime = (microtime(true) - $start) * 1000;
+
+    $start = microtime(true);
+    \Phillarmonic\FrankenZstd\compressMany($items);
+    $batchTime = (microtime(true) - $start) * 1000;
+
+    printf("%-8s %-8d %-14.2f %-14.2f %-10.1fx\n", $sizeName, $count, $loopTime, $batchTime, $loopTime / $batchTime);
+}
+
+echo "\nParallel Compression Test\n";
+echo "-------------------------\n";
+
+// Pseudo-text, so matches are found but the payload is not trivially repetitive
+mt_srand(42);
+$words = [];
+for ($i = 0; $i < 4096; $i++) {
+    $words[] = substr(md5((string) $i), 0, mt_rand(3, 10));
+}
+$parts = [];
+for ($i = 0; $i < 4 * 1024 * 1024; $i++) {
+    $parts[] = $words[mt_rand(0, 4095)];
+}
+$largeData = implode(' ', $parts);
+unset($parts);
+$largeSize = strlen($largeData);
+
+printf("Payload: %.1f MB at level %d\n", $largeSize / 1048576, Compressor::LEVEL_BEST);
+printf("%-8s %-12s %-14s %-12s %-10s\n", "Threads", "Time(ms)", "Speed(MB/s)", "Ratio", "Speedup");
+echo str_repeat("-", 60) . "\n";
+
+$baseline = null;
+foreach ([1, 2, 4, 8, 16] as $threads) {
+    $compressor = Compressor::create(Compressor::LEVEL_BEST, Compressor::WINDOW_SIZE_DEFAULT, 0, $threads);
+    $compressor->compress($largeData); // Warm up the internal encoders
+
+    $start = microtime(true);
+    $compressed = $compressor->compress($largeData);
+    $time = (microtime(true) - $start) * 1000;
+    $compressor->close();
+
+    if (\Phillarmonic\FrankenZstd\decompress($compressed) !== $largeData) {
+        echo "❌ Round trip failed with $threads threads\n";
+        continue;
+    }
+
+    $baseline ??= $time;
+    printf("%-8d %-12.2f %-14.2f %-12.2f %-10.1fx\n",
+           $threads, $time, ($largeSize / 1048576) / ($time / 1000), $largeSize / strlen($compressed), $baseline / $time);
+}
+unset($largeData, $compressed);
+
+echo "\nShared Compressor Test\n";
+echo "----------------------\n";
+
+// One Compressor serving concurrent callers: a batch of N items runs on N
+// goroutines against the same encoder and decoder. Throughput should grow
+// with N up to the core count instead of flattening on a shared lock.
+$segments = [];
+for ($i = 0; $i < 16; $i++) {
+    $parts = [];
+    for ($j = 0; $j < 160000; $j++) {
+        $parts[] = $words[mt_rand(0, 4095)];
+    }
+    $segments[] = substr(implode(' ', $parts), 0, 1024 * 1024);
+}
+unset($parts);
+
+$shared = Compressor::create(Compressor::LEVEL_DEFAULT);
+$shared->compressMany(array_slice($segments, 0, 4)); // Warm up the internal encoders
+
+printf("%-8s %-18s %-18s %-10s\n", "Threads", "Compress(MB/s)", "Decompress(MB/s)", "Scaling");
+echo str_repeat("-", 58) . "\n";
+
+$baseline = null;
+foreach ([1, 2, 4, 8, 16] as $threads) {
+    $items = array_slice($segments, 0, $threads);
+
+    $start = microtime(true);
+    $compressed = $shared->compressMany($items);
+    $compressTime = microtime(true) - $start;
+
+    $start = microtime(true);
+    $decompressed = $shared->decompressMany($compressed);
+    $decompressTime = microtime(true) - $start;
+
+    if ($decompressed !== $items) {
+        echo "❌ Round trip failed with $threads threads\n";
+        continue;
+    }
+
+    $compressSpeed = $threads / $compressTime;
+    $baseline ??= $compressSpeed;
+    printf("%-8d %-18.2f %-18.2f %-10.1fx\n",
+           $threads, $compressSpeed, $threads / $decompressTime, $compressSpeed / $baseline);
+}
+$shared->close();
+unset($segments, $items, $compressed, $decompressed);
+
 echo "\nMemory Usage Test\n";
 echo "-----------------\n";
 
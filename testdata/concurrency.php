@@ -0,0 +1,38 @@
+<?php
+
+use Phillarmonic\FrankenZstd\Compressor;
+
+// Per-request workload for the concurrency benchmark. Every request runs on
+// its own FrankenPHP thread, so hammering this page with a load generator
+// exercises the compressor registry from many threads at once. With
+// ?persistent=1 every thread shares one process-wide compressor instead of
+// creating its own per request:
+//
+//   just benchmark-concurrency 64
+
+header('Content-Type: text/plain; charset=utf-8');
+
+$operations = (int)($_GET['ops'] ?? 200);
+$payload = str_repeat('{"id":123,"name":"concurrency","tags":["a","b","c"]}', 20);
+
+$startTime = microtime(true);
+
+$compressor = empty($_GET['persistent'])
+    ? Compressor::create(Compressor::LEVEL_FASTEST)
+    : Compressor::persistent('concurrency', Compressor::LEVEL_FASTEST);
+for ($i = 0; $i < $operations; $i++) {
+    $compressed = $compressor->compress($payload);
+    if ($compressor->decompress($compressed) !== $payload) {
+        http_response_code(500);
+        echo "ERROR: round trip mismatch\n";
+        exit(1);
+    }
+    $compressor->getStats();
+}
+$compressor->close();
+
+$elapsed = microtime(true) - $startTime;
+
+printf("operations: %d\n", $operations * 3);
+printf("time(ms): %.2f\n", $elapsed * 1000);
+printf("ops/s: %.0f\n", ($operations * 3) / $elapsed);
@@ -33,7 +33,23 @@ echo "\nChecking functions...\n";
 $functions = [
     'Phillarmonic\\FrankenZstd\\compress',
     'Phillarmonic\\FrankenZstd\\decompress',
-    'Phillarmonic\\FrankenZstd\\getInfo'
+    'Phillarmonic\\FrankenZstd\\compressMany',
+    'Phillarmonic\\FrankenZstd\\decompressMany',
+    'Phillarmonic\\FrankenZstd\\compressDelta',
+    'Phillarmonic\\FrankenZstd\\decompressDelta',
+    'Phillarmonic\\FrankenZstd\\compressFile',
+    'Phillarmonic\\FrankenZstd\\decompressFile',
+    'Phillarmonic\\FrankenZstd\\compressAsync',
+    'Phillarmonic\\FrankenZstd\\decompressAsync',
+    'Phillarmonic\\FrankenZstd\\ob_handler',
+    'Phillarmonic\\FrankenZstd\\compressSeekable',
+    'Phillarmonic\\FrankenZstd\\decompressRange',
+    'Phillarmonic\\FrankenZstd\\trainDictionary',
+    'Phillarmonic\\FrankenZstd\\registerDictionary',
+    'Phillarmonic\\FrankenZstd\\getInfo',
+    'Phillarmonic\\FrankenZstd\\getMetrics',
+    'Phillarmonic\\FrankenZstd\\getMemoryUsage',
+    'Phillarmonic\\FrankenZstd\\getCacheStats'
 ];
 
 foreach ($functions as $func) {
@@ -49,7 +65,10 @@ foreach ($functions as $func) {
 echo "\nChecking classes...\n";
 $classes = [
     'Phillarmonic\\FrankenZstd\\Compressor',
-    'Phillarmonic\\FrankenZstd\\CompressionException'
+    'Phillarmonic\\FrankenZstd\\CompressionException',
+    'Phillarmonic\\FrankenZstd\\StreamCompressor',
+    'Phillarmonic\\FrankenZstd\\StreamDecompressor',
+    'Phillarmonic\\FrankenZstd\\Future'
 ];
 
 foreach ($classes as $class) {
@@ -61,6 +80,21 @@ foreach ($classes as $class) {
     }
 }
 
+// Check stream wrapper and filters
+echo "\nChecking stream wrapper and filters...\n";
+if (in_array('compress.zstd', stream_get_wrappers(), true)) {
+    echo "✅ Stream wrapper compress.zstd:// is registered\n";
+} else {
+    echo "❌ Stream wrapper compress.zstd:// is NOT registered\n";
+    $allPassed = false;
+}
+if (in_array('zstd.*', stream_get_filters(), true)) {
+    echo "✅ Stream filters zstd.* are registered\n";
+} else {
+    echo "❌ Stream filters zstd.* are NOT registered\n";
+    $allPassed = false;
+}
+
 // Check class constants
 echo "\nChecking class constants...\n";
 try {
@@ -86,7 +120,7 @@ try {
 echo "\nChecking class methods...\n";
 try {
     $reflection = new ReflectionClass('Phillarmonic\\FrankenZstd\\Compressor');
-    $methods = ['create', 'compress', 'decompress', 'getStats', 'close'];
+    $methods = ['create', 'persistent', 'adaptive', 'compress', 'decompress', 'compressMany', 'decompressMany', 'getStats', 'close'];
     
     foreach ($methods as $method) {
         if ($reflection->hasMethod($method)) {
@@ -74,6 +74,104 @@ try {
     echo "Compression ratio: " . number_format($stats['compressionRatio'], 2) . ":1<br>\n";
     echo "Compression time: " . number_format($stats['compressionTime'] * 1000, 2) . " ms<br>\n";
     
+    $compressor->compress($data);
+    $compressor->decompress($compressed2);
+    try {
+        $compressor->decompress('not zstd');
+    } catch (CompressionException $e) {
+    }
+    $totals = $compressor->getStats();
+    echo "Cumulative compressions: {$totals['compress']['operations']}, bytes in: {$totals['compress']['bytesIn']}<br>\n";
+    echo "Cumulative totals: " . (
+        $totals['compress']['operations'] === 2 && $totals['compress']['bytesIn'] === 2 * strlen($data) &&
+        $totals['decompress']['operations'] === 2 && $totals['decompress']['errors'] === 1 ? "✅ YES" : "❌ NO"
+    ) . "<br>\n";
+    $metrics = \Phillarmonic\FrankenZstd\getMetrics();
+    echo "Process metrics for level " . Compressor::LEVEL_DEFAULT . ": " . (
+        ($metrics['compress'][Compressor::LEVEL_DEFAULT]['operations'] ?? 0) >= 3 && $metrics['decompress']['operations'] >= 3 ? "✅ YES" : "❌ NO"
+    ) . "<br>\n";
+    
+    // Test output limits
+    echo "<h3>Output Limits</h3>\n";
+    try {
+        \Phillarmonic\FrankenZstd\decompress($compressed, strlen($data) - 1);
+        echo "Declared size over the limit rejected: ❌ NO<br>\n";
+    } catch (CompressionException $e) {
+        echo "Declared size over the limit rejected: ✅ YES<br>\n";
+    }
+    echo "Output at the limit accepted: " . (\Phillarmonic\FrankenZstd\decompress($compressed, strlen($data)) === $data ? "✅ YES" : "❌ NO") . "<br>\n";
+    $unsized = \Phillarmonic\FrankenZstd\StreamCompressor::create();
+    $bomb = $unsized->write(str_repeat("\0", 8 << 20)) . $unsized->finish();
+    $unsized->close();
+    try {
+        \Phillarmonic\FrankenZstd\decompress($bomb, 1 << 20);
+        echo "Unsized frame stopped at the limit: ❌ NO<br>\n";
+    } catch (CompressionException $e) {
+        echo "Unsized frame stopped at the limit: ✅ YES<br>\n";
+    }
+    echo "Unsized frame within the limit: " . (strlen(\Phillarmonic\FrankenZstd\decompress($bomb, 8 << 20)) === 8 << 20 ? "✅ YES" : "❌ NO") . "<br>\n";
+
+    // Test persistent compressors
+    echo "<h3>Persistent Compressors</h3>\n";
+    $persistent = Compressor::persistent('index-test', Compressor::LEVEL_DEFAULT);
+    $persistentCompressed = $persistent->compress($data);
+    $persistent->close();
+    $persistentAgain = Compressor::persistent('index-test', Compressor::LEVEL_DEFAULT);
+    echo "Persistent compressor survives close(): " . (
+        $persistentAgain->persistent && $persistentAgain->decompress($persistentCompressed) === $data ? "✅ YES" : "❌ NO"
+    ) . "<br>\n";
+    try {
+        Compressor::persistent('index-test', Compressor::LEVEL_BEST);
+        echo "Conflicting settings rejected: ❌ NO<br>\n";
+    } catch (CompressionException $e) {
+        echo "Conflicting settings rejected: ✅ YES<br>\n";
+    }
+
+    $memory = \Phillarmonic\FrankenZstd\getMemoryUsage();
+    echo "Codec memory in use: " . number_format($memory['used'] / 1048576, 1) . " MB (budget: " . ($memory['budget'] ?: 'none') . ", evictions: {$memory['evictions']})<br>\n";
+    $before = $memory['used'];
+    $sized = Compressor::create(Compressor::LEVEL_DEFAULT, 20);
+    $sized->decompress($sized->compress(str_repeat('window ', 1000)));
+    $during = \Phillarmonic\FrankenZstd\getMemoryUsage()['used'];
+    $sized->close();
+    // One window for the encoder and one for the decoder; only concurrent
+    // operations add more
+    echo "Codec memory accounted: " . (
+        $during - $before === 2 << 20 && \Phillarmonic\FrankenZstd\getMemoryUsage()['used'] === $before ? "✅ YES" : "❌ NO"
+    ) . "<br>\n";
+
+    // Test adaptive compressors: an unreachable target backs the size class
+    // off to the fastest level, a trivial one never does
+    echo "<h3>Adaptive Compressors</h3>\n";
+    $small = str_repeat('Adaptive payload ', 32);
+    $strict = Compressor::adaptive(1e9);
+    $strictCompressed = $strict->compress($small);
+    $strictStats = $strict->getStats();
+    $lenient = Compressor::adaptive(0.001);
+    $lenientCompressed = $lenient->compress($small);
+    echo "Adaptive round trip: " . (
+        $strict->decompress($strictCompressed) === $small && $lenient->decompress($lenientCompressed) === $small ? "✅ YES" : "❌ NO"
+    ) . "<br>\n";
+    echo "Levels follow the target: " . (
+        $strict->level === 0 && $strictStats['adaptive']['classes'][0]['level'] === Compressor::LEVEL_FASTEST
+        && $lenient->getStats()['adaptive']['classes'][0]['level'] >= Compressor::LEVEL_DEFAULT ? "✅ YES" : "❌ NO"
+    ) . "<br>\n";
+    echo "Fixed level has no adaptive stats: " . (!isset($compressor->getStats()['adaptive']) ? "✅ YES" : "❌ NO") . "<br>\n";
+    $strict->close();
+    $lenient->close();
+
+    // Test the result cache (enabled with the cache_size Caddyfile option)
+    $cacheBefore = \Phillarmonic\FrankenZstd\getCacheStats();
+    $cachedPayload = str_repeat('Cached payload ', 4096);
+    $firstCompressed = \Phillarmonic\FrankenZstd\compress($cachedPayload, 5);
+    $secondCompressed = \Phillarmonic\FrankenZstd\compress($cachedPayload, 5);
+    $cacheAfter = \Phillarmonic\FrankenZstd\getCacheStats();
+    echo "Result cache: " . ($cacheAfter['capacity'] ? number_format($cacheAfter['capacity'] / 1048576, 1) . " MB, {$cacheAfter['entries']} entries" : "disabled") . "<br>\n";
+    echo "Repeated compression consistent: " . (
+        $firstCompressed === $secondCompressed && \Phillarmonic\FrankenZstd\decompress($secondCompressed) === $cachedPayload
+        && (!$cacheAfter['capacity'] || $cacheAfter['hits'] > $cacheBefore['hits']) ? "✅ YES" : "❌ NO"
+    ) . "<br>\n";
+
     // Test different compression levels
     echo "<h3>Different Compression Levels</h3>\n";
     $testData = str_repeat("Test data for compression level comparison. ", 50);
@@ -90,6 +188,279 @@ try {
         $levelCompressor->close();
     }
     
+    // Test quick function levels
+    echo "<h3>Quick Function Levels</h3>\n";
+    foreach ([Compressor::LEVEL_FASTEST, Compressor::LEVEL_DEFAULT, Compressor::LEVEL_BEST, Compressor::LEVEL_ULTRA] as $level) {
+        $levelCompressed = \Phillarmonic\FrankenZstd\compress($testData, $level);
+        $matches = \Phillarmonic\FrankenZstd\decompress($levelCompressed) === $testData;
+        echo "Level $level: " . strlen($levelCompressed) . " bytes, round trip: " . ($matches ? "✅ YES" : "❌ NO") . "<br>\n";
+    }
+    try {
+        \Phillarmonic\FrankenZstd\compress($testData, 23);
+        echo "Invalid level rejected: ❌ NO<br>\n";
+    } catch (CompressionException $e) {
+        echo "Invalid level rejected: ✅ YES<br>\n";
+    }
+    
+    // Test parallel compression
+    echo "<h3>Parallel Compression</h3>\n";
+    $largeData = '';
+    for ($i = 0; $i < 200000; $i++) {
+        $largeData .= "record $i: " . md5((string) $i) . "\n";
+    }
+    $parallelCompressor = Compressor::create(Compressor::LEVEL_DEFAULT, Compressor::WINDOW_SIZE_DEFAULT, 0, 4);
+    $parallelCompressed = $parallelCompressor->compress($largeData);
+    echo "Parallel compressed " . strlen($largeData) . " bytes into " . strlen($parallelCompressed) . " bytes with {$parallelCompressor->threads} threads<br>\n";
+    echo "Parallel round trip: " . (\Phillarmonic\FrankenZstd\decompress($parallelCompressed) === $largeData ? "✅ YES" : "❌ NO") . "<br>\n";
+    $parallelDecompressor = \Phillarmonic\FrankenZstd\StreamDecompressor::create();
+    $parallelStreamed = $parallelDecompressor->write($parallelCompressed) . $parallelDecompressor->finish();
+    $parallelDecompressor->close();
+    echo "Parallel output is a standard stream: " . ($parallelStreamed === $largeData ? "✅ YES" : "❌ NO") . "<br>\n";
+    $parallelCompressor->close();
+    
+    // Test seekable compression
+    echo "<h3>Seekable Compression</h3>\n";
+    $seekable = \Phillarmonic\FrankenZstd\compressSeekable($largeData, Compressor::LEVEL_DEFAULT, 65536);
+    echo "Seekable compressed " . strlen($largeData) . " bytes into " . strlen($seekable) . " bytes<br>\n";
+    echo "Seekable readable by decompress(): " . (\Phillarmonic\FrankenZstd\decompress($seekable) === $largeData ? "✅ YES" : "❌ NO") . "<br>\n";
+    $rangesMatch = true;
+    foreach ([[0, 10], [65530, 20], [100000, 300000], [strlen($largeData) - 5, 100]] as [$offset, $length]) {
+        $range = \Phillarmonic\FrankenZstd\decompressRange($seekable, $offset, $length);
+        $rangesMatch = $rangesMatch && $range === substr($largeData, $offset, $length);
+    }
+    echo "Ranges match: " . ($rangesMatch ? "✅ YES" : "❌ NO") . "<br>\n";
+    try {
+        \Phillarmonic\FrankenZstd\decompressRange($parallelCompressed, 0, 10);
+        echo "Non-seekable payload rejected: ❌ NO<br>\n";
+    } catch (CompressionException $e) {
+        echo "Non-seekable payload rejected: ✅ YES<br>\n";
+    }
+    $craftedTable = substr_replace($seekable, pack('V', 0xFFFFFFFF), -13, 4);
+    try {
+        \Phillarmonic\FrankenZstd\decompressRange($craftedTable, strlen($largeData) - 5, 10);
+        echo "Oversized seek table entry rejected: ❌ NO<br>\n";
+    } catch (CompressionException $e) {
+        echo "Oversized seek table entry rejected: ✅ YES<br>\n";
+    }
+    
+    // Test batch compression
+    echo "<h3>Batch Compression</h3>\n";
+    $batch = ['user:1' => str_repeat('alpha ', 200), 'user:2' => str_repeat('beta ', 300), 7 => ''];
+    $compressedBatch = \Phillarmonic\FrankenZstd\compressMany($batch, 6);
+    echo "Batch keys preserved: " . (array_keys($compressedBatch) === array_keys($batch) ? "✅ YES" : "❌ NO") . "<br>\n";
+    echo "Batch round trip: " . (\Phillarmonic\FrankenZstd\decompressMany($compressedBatch) === $batch ? "✅ YES" : "❌ NO") . "<br>\n";
+    $compressorBatch = $compressor->decompressMany($compressor->compressMany($batch));
+    echo "Compressor batch round trip: " . ($compressorBatch === $batch ? "✅ YES" : "❌ NO") . "<br>\n";
+    $mixedBatch = \Phillarmonic\FrankenZstd\decompressMany(['good' => $compressedBatch['user:1'], 'bad' => 'not zstd']);
+    echo "Bad item reported without failing the batch: " . (
+        $mixedBatch['good'] === $batch['user:1'] && $mixedBatch['bad'] instanceof CompressionException ? "✅ YES" : "❌ NO"
+    ) . "<br>\n";
+    
+    // Test delta compression
+    echo "<h3>Delta Compression</h3>\n";
+    $versions = [];
+    for ($i = 0; $i < 2000; $i++) {
+        $versions[] = ['id' => $i, 'sku' => sprintf('SKU-%06d', $i * 7919 % 1000003), 'price' => $i * 13 % 997, 'stock' => $i % 17];
+    }
+    $reference = json_encode($versions);
+    $versions[1000]['price'] = 1;
+    $newVersion = json_encode($versions);
+    $patch = \Phillarmonic\FrankenZstd\compressDelta($reference, $newVersion);
+    echo "Standalone: " . strlen(\Phillarmonic\FrankenZstd\compress($newVersion)) . " bytes, patch: " . strlen($patch) . " bytes<br>\n";
+    echo "Delta round trip: " . (\Phillarmonic\FrankenZstd\decompressDelta($reference, $patch) === $newVersion ? "✅ YES" : "❌ NO") . "<br>\n";
+    try {
+        \Phillarmonic\FrankenZstd\decompressDelta($newVersion, $patch);
+        echo "Wrong reference rejected: ❌ NO<br>\n";
+    } catch (CompressionException $e) {
+        echo "Wrong reference rejected: ✅ YES<br>\n";
+    }
+    
+    // Test file to file compression
+    echo "<h3>File Compression</h3>\n";
+    $plainFile = tempnam(sys_get_temp_dir(), 'zstd');
+    $zstdFile = $plainFile . '.zst';
+    $restoredFile = $plainFile . '.out';
+    $fileData = str_repeat('File compression test line. ', 400000) . random_bytes(1024);
+    file_put_contents($plainFile, $fileData);
+    $fileStats = \Phillarmonic\FrankenZstd\compressFile($plainFile, $zstdFile, 3, 0, 4);
+    echo "Compressed {$fileStats['bytesIn']} bytes into {$fileStats['bytesOut']} in " . number_format($fileStats['time'] * 1000, 2) . " ms<br>\n";
+    $restoreStats = \Phillarmonic\FrankenZstd\decompressFile($zstdFile, $restoredFile);
+    echo "File round trip: " . (
+        file_get_contents($restoredFile) === $fileData && $fileStats['bytesOut'] === filesize($zstdFile)
+        && $restoreStats['bytesOut'] === strlen($fileData) ? "✅ YES" : "❌ NO"
+    ) . "<br>\n";
+    echo "Readable by decompress(): " . (\Phillarmonic\FrankenZstd\decompress(file_get_contents($zstdFile)) === $fileData ? "✅ YES" : "❌ NO") . "<br>\n";
+    try {
+        \Phillarmonic\FrankenZstd\decompressFile($zstdFile, $restoredFile, 1 << 20);
+        echo "File output limit enforced: ❌ NO<br>\n";
+    } catch (CompressionException $e) {
+        echo "File output limit enforced, previous output kept: " . (file_get_contents($restoredFile) === $fileData ? "✅ YES" : "❌ NO") . "<br>\n";
+    }
+    try {
+        \Phillarmonic\FrankenZstd\compressFile($plainFile, $plainFile);
+        echo "Same file refused: ❌ NO<br>\n";
+    } catch (CompressionException $e) {
+        echo "Same file refused: " . (filesize($plainFile) === strlen($fileData) ? "✅ YES" : "❌ NO") . "<br>\n";
+    }
+    file_put_contents($plainFile, '');
+    \Phillarmonic\FrankenZstd\compressFile($plainFile, $zstdFile);
+    \Phillarmonic\FrankenZstd\decompressFile($zstdFile, $restoredFile);
+    echo "Empty file round trip: " . (filesize($zstdFile) > 0 && file_get_contents($restoredFile) === '' ? "✅ YES" : "❌ NO") . "<br>\n";
+    @unlink($plainFile);
+    @unlink($zstdFile);
+    @unlink($restoredFile);
+    
+    // Test asynchronous compression
+    echo "<h3>Asynchronous Compression</h3>\n";
+    $asyncData = str_repeat('Asynchronous compression test. ', 10000);
+    $future = \Phillarmonic\FrankenZstd\compressAsync($asyncData, 6);
+    $asyncCompressed = $future->wait();
+    echo "Async round trip: " . (\Phillarmonic\FrankenZstd\decompressAsync($asyncCompressed)->wait() === $asyncData ? "✅ YES" : "❌ NO") . "<br>\n";
+    echo "Ready after wait, result kept: " . ($future->isReady() && $future->wait() === $asyncCompressed ? "✅ YES" : "❌ NO") . "<br>\n";
+    $asyncResults = \Phillarmonic\FrankenZstd\Future::waitAll([
+        'good' => \Phillarmonic\FrankenZstd\decompressAsync($asyncCompressed),
+        'bad' => \Phillarmonic\FrankenZstd\decompressAsync('not zstd'),
+    ]);
+    echo "waitAll reports failures per future: " . (
+        $asyncResults['good'] === $asyncData && $asyncResults['bad'] instanceof CompressionException ? "✅ YES" : "❌ NO"
+    ) . "<br>\n";
+    
+    // Test output buffer handler, captured by an outer buffer. The response
+    // is only encoded when the request accepts zstd.
+    echo "<h3>Output Buffer Handler</h3>\n";
+    $page = str_repeat("<p>Streamed response body</p>\n", 2000);
+    ob_start();
+    ob_start('Phillarmonic\\FrankenZstd\\ob_handler');
+    echo substr($page, 0, 20000);
+    ob_flush();
+    echo substr($page, 20000);
+    ob_end_flush();
+    $handled = ob_get_clean();
+    $encoded = in_array('Content-Encoding: zstd', headers_list(), true);
+    header_remove('Content-Encoding');
+    $decoded = $encoded ? \Phillarmonic\FrankenZstd\decompress($handled) : $handled;
+    echo "Output handler round trip (" . ($encoded ? "zstd, " . strlen($handled) . " bytes" : "passed through") . "): " . ($decoded === $page ? "✅ YES" : "❌ NO") . "<br>\n";
+    
+    ob_start();
+    ob_start('Phillarmonic\\FrankenZstd\\ob_handler');
+    echo substr($page, 0, 20000);
+    $nested = @ob_start('Phillarmonic\\FrankenZstd\\ob_handler');
+    echo substr($page, 20000);
+    if ($nested) {
+        ob_end_flush();
+    }
+    ob_end_flush();
+    $handled = ob_get_clean();
+    $encoded = in_array('Content-Encoding: zstd', headers_list(), true);
+    header_remove('Content-Encoding');
+    $decoded = $encoded ? \Phillarmonic\FrankenZstd\decompress($handled) : $handled;
+    echo "Nested output handler refused: " . (!$nested && $decoded === $page ? "✅ YES" : "❌ NO") . "<br>\n";
+    
+    ob_start('Phillarmonic\\FrankenZstd\\ob_handler');
+    echo "x";
+    ob_end_clean();
+    $encoded = in_array('Content-Encoding: zstd', headers_list(), true);
+    header_remove('Content-Encoding');
+    echo "Cleaned output handler drops Content-Encoding: " . (!$encoded ? "✅ YES" : "❌ NO") . "<br>\n";
+    
+    // Test dictionary compression
+    echo "<h3>Dictionary Compression</h3>\n";
+    $samples = [];
+    for ($i = 0; $i < 200; $i++) {
+        $samples[] = json_encode(['id' => $i, 'name' => "user$i", 'email' => "user$i@example.com", 'active' => $i % 2 === 0]);
+    }
+    $dictionary = \Phillarmonic\FrankenZstd\trainDictionary($samples);
+    $dictId = \Phillarmonic\FrankenZstd\registerDictionary($dictionary);
+    echo "Dictionary ID: $dictId, size: " . strlen($dictionary) . " bytes<br>\n";
+    
+    $document = json_encode(['id' => 1000, 'name' => 'user1000', 'email' => 'user1000@example.com', 'active' => true]);
+    $plainCompressed = \Phillarmonic\FrankenZstd\compress($document);
+    $dictCompressed = \Phillarmonic\FrankenZstd\compress($document, Compressor::LEVEL_DEFAULT, $dictId);
+    echo "Without dictionary: " . strlen($plainCompressed) . " bytes, with dictionary: " . strlen($dictCompressed) . " bytes<br>\n";
+    echo "Dictionary round trip: " . (\Phillarmonic\FrankenZstd\decompress($dictCompressed) === $document ? "✅ YES" : "❌ NO") . "<br>\n";
+    
+    $dictCompressor = Compressor::create(Compressor::LEVEL_DEFAULT, Compressor::WINDOW_SIZE_DEFAULT, $dictId);
+    $dictCompressed2 = $dictCompressor->compress($document);
+    echo "Compressor dictionary round trip: " . ($compressor->decompress($dictCompressed2) === $document ? "✅ YES" : "❌ NO") . "<br>\n";
+    $dictCompressor->close();
+    
+    // Test streaming compression
+    echo "<h3>Streaming Compression</h3>\n";
+    $streamCompressor = \Phillarmonic\FrankenZstd\StreamCompressor::create();
+    $streamCompressed = '';
+    $streamOriginal = '';
+    for ($i = 0; $i < 100; $i++) {
+        $chunk = str_repeat("Streaming chunk $i. ", 500);
+        $streamOriginal .= $chunk;
+        $streamCompressed .= $streamCompressor->write($chunk);
+        if ($i % 10 === 0) {
+            $streamCompressed .= $streamCompressor->flush();
+        }
+    }
+    $streamCompressed .= $streamCompressor->finish();
+    $streamCompressor->close();
+    echo "Streamed " . strlen($streamOriginal) . " bytes into " . strlen($streamCompressed) . " bytes<br>\n";
+    echo "Stream readable by decompress(): " . (\Phillarmonic\FrankenZstd\decompress($streamCompressed) === $streamOriginal ? "✅ YES" : "❌ NO") . "<br>\n";
+    
+    $streamDecompressor = \Phillarmonic\FrankenZstd\StreamDecompressor::create();
+    $streamDecompressed = '';
+    foreach (str_split($streamCompressed, 1000) as $chunk) {
+        $streamDecompressed .= $streamDecompressor->write($chunk);
+    }
+    $streamDecompressed .= $streamDecompressor->finish();
+    $streamDecompressor->close();
+    echo "Stream round trip: " . ($streamDecompressed === $streamOriginal ? "✅ YES" : "❌ NO") . "<br>\n";
+    
+    // A tiny, highly compressible chunk handed out in capped pieces
+    $zeroes = \Phillarmonic\FrankenZstd\compress(str_repeat("\0", 4 << 20));
+    $cappedDecompressor = \Phillarmonic\FrankenZstd\StreamDecompressor::create();
+    $piece = $cappedDecompressor->write($zeroes, 100000);
+    $largest = strlen($piece);
+    $cappedTotal = strlen($piece);
+    while (($piece = $cappedDecompressor->read(100000)) !== '') {
+        $largest = max($largest, strlen($piece));
+        $cappedTotal += strlen($piece);
+    }
+    $cappedTotal += strlen($cappedDecompressor->finish(100000));
+    $cappedDecompressor->close();
+    echo "Capped stream output: " . ($largest === 100000 && $cappedTotal === 4 << 20 ? "✅ YES" : "❌ NO") . "<br>\n";
+    
+    $truncatedDecompressor = \Phillarmonic\FrankenZstd\StreamDecompressor::create();
+    try {
+        $truncatedDecompressor->write(substr($streamCompressed, 0, intdiv(strlen($streamCompressed), 2)));
+        $truncatedDecompressor->finish();
+        echo "Truncated stream rejected: ❌ NO<br>\n";
+    } catch (CompressionException $e) {
+        echo "Truncated stream rejected: ✅ YES<br>\n";
+    }
+    $truncatedDecompressor->close();
+
+    // Test stream wrapper and filters
+    echo "<h3>Stream Wrapper and Filters</h3>\n";
+    $zstdFile = tempnam(sys_get_temp_dir(), 'zstd');
+    file_put_contents("compress.zstd://$zstdFile", $streamOriginal);
+    echo "Wrapper wrote " . filesize($zstdFile) . " compressed bytes<br>\n";
+    echo "Wrapper file readable by decompress(): " . (\Phillarmonic\FrankenZstd\decompress(file_get_contents($zstdFile)) === $streamOriginal ? "✅ YES" : "❌ NO") . "<br>\n";
+    echo "Wrapper round trip: " . (file_get_contents("compress.zstd://$zstdFile") === $streamOriginal ? "✅ YES" : "❌ NO") . "<br>\n";
+    unlink($zstdFile);
+
+    $temp = fopen('php://temp', 'w+b');
+    $filter = stream_filter_append($temp, 'zstd.compress', STREAM_FILTER_WRITE, ['level' => 6]);
+    fwrite($temp, $streamOriginal);
+    stream_filter_remove($filter);
+    rewind($temp);
+    stream_filter_append($temp, 'zstd.decompress', STREAM_FILTER_READ);
+    echo "Filter round trip: " . (stream_get_contents($temp) === $streamOriginal ? "✅ YES" : "❌ NO") . "<br>\n";
+    fclose($temp);
+    
+    $temp = fopen('php://temp', 'w+b');
+    fwrite($temp, \Phillarmonic\FrankenZstd\compress(str_repeat("\0", 4 << 20)));
+    rewind($temp);
+    stream_filter_append($temp, 'zstd.decompress', STREAM_FILTER_READ, ['maxOutput' => 1 << 20]);
+    $limited = @stream_get_contents($temp);
+    echo "Filter stops at maxOutput: " . (strlen((string) $limited) <= (1 << 20) + 8192 ? "✅ YES" : "❌ NO") . "<br>\n";
+    fclose($temp);
+
     // Test extension info
     echo "<h3>Extension Information</h3>\n";
     $info = \Phillarmonic\FrankenZstd\getInfo();
@@ -1,4 +1,6 @@
 #include <php.h>
+#include <SAPI.h>
+#include <php_output.h>
 #include <zend_exceptions.h>
 #include <ext/standard/info.h>
 #include "zstd.h"
@@ -10,14 +12,26 @@
 // Exception class entry
 zend_class_entry *compression_exception_ce;
 
+ZEND_DECLARE_MODULE_GLOBALS(zstd)
+
 // Compressor class entry
 zend_class_entry *compressor_ce;
 
+// Stream class entries
+zend_class_entry *stream_compressor_ce;
+zend_class_entry *stream_decompressor_ce;
+
+// Future class entry
+zend_class_entry *future_ce;
+
 // Object structure for Compressor instances
 typedef struct {
-    zend_string *name;
+    uint64_t handle;
     int level;
     int window_size;
+    zend_long dict_id;
+    int threads;
+    bool persistent;
     zend_object std;
 } compressor_object;
 
@@ -25,226 +39,1584 @@ static inline compressor_object *compressor_from_obj(zend_object *obj) {
     return (compressor_object*)((char*)(obj) - XtOffsetOf(compressor_object, std));
 }
 
-#define Z_COMPRESSOR_OBJ_P(zv) compressor_from_obj(Z_OBJ_P(zv))
+#define Z_COMPRESSOR_OBJ_P(zv) compressor_from_obj(Z_OBJ_P(zv))
+
+// Object structure for StreamCompressor and StreamDecompressor instances
+typedef struct {
+    uint64_t handle;
+    zend_object std;
+} stream_object;
+
+static inline stream_object *stream_from_obj(zend_object *obj) {
+    return (stream_object*)((char*)(obj) - XtOffsetOf(stream_object, std));
+}
+
+#define Z_STREAM_OBJ_P(zv) stream_from_obj(Z_OBJ_P(zv))
+
+// Object structure for Future instances. The input and the preallocated
+// output are owned here until the result is collected, since the goroutine
+// reads and writes them in place.
+typedef struct {
+    uint64_t handle;
+    zend_string *input;
+    zend_string *output;
+    zend_string *result;
+    zend_string *error;
+    const char *failure;
+    zend_object std;
+} future_object;
+
+static inline future_object *future_from_obj(zend_object *obj) {
+    return (future_object*)((char*)(obj) - XtOffsetOf(future_object, std));
+}
+
+#define Z_FUTURE_OBJ_P(zv) future_from_obj(Z_OBJ_P(zv))
+
+// Hands an output produced by Go back to PHP. Go writes straight into the
+// zend_string allocated here; only when the output outgrew it does Go park
+// the bytes behind a handle, which are then copied once into an exact fit.
+static void return_go_result(zval *return_value, zend_string *out, size_t out_len, uintptr_t pending)
+{
+    if (pending) {
+        if (out) zend_string_efree(out);
+        out = zend_string_alloc(out_len, 0);
+        go_result_take(pending, ZSTR_VAL(out));
+    } else if (out_len == 0) {
+        if (out) zend_string_efree(out);
+        RETURN_EMPTY_STRING();
+    } else if (ZSTR_LEN(out) - out_len > (ZSTR_LEN(out) >> 2)) {
+        // Give back the unused tail of a compress bound. Unless the
+        // allocator shrinks it in place, that copies the output.
+        zend_string *shrunk = zend_string_truncate(out, out_len, 0);
+        if (shrunk != out) {
+            go_record_copy(out_len);
+        }
+        out = shrunk;
+    }
+
+    ZSTR_LEN(out) = out_len;
+    ZSTR_VAL(out)[out_len] = '\0';
+    RETURN_NEW_STR(out);
+}
+
+// Allocates the output of a decompression from the content size declared by
+// the frames, or from their block bound when they declare none, never past
+// max_output. Allocates nothing when Go has to size it.
+static zend_string *alloc_decompressed(zend_string *compressed_data, zend_long max_output)
+{
+    int64_t size = go_decompressed_size(compressed_data, max_output);
+    if (size <= 0) {
+        return NULL;
+    }
+    return zend_string_alloc((size_t)size, 0);
+}
+
+// Dictionary IDs are 32 bits in the zstd frame format, 0 meaning none
+static bool check_dict_id(zend_long dict_id)
+{
+    if (dict_id < 0 || dict_id > (zend_long)UINT32_MAX) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Invalid dictionary ID: " ZEND_LONG_FMT " (must be 0-4294967295)", dict_id);
+        return false;
+    }
+    return true;
+}
+
+// Output limits are byte counts, 0 meaning none
+static bool check_max_output(zend_long max_output)
+{
+    if (max_output < 0) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Invalid maximum output size: " ZEND_LONG_FMT " (must be 0 or more)", max_output);
+        return false;
+    }
+    return true;
+}
+
+// Converts the totals of an operation to a PHP array
+static void totals_to_array(zval *array, const franken_zstd_totals *totals)
+{
+    array_init(array);
+    add_assoc_long(array, "operations", totals->operations);
+    add_assoc_long(array, "errors", totals->errors);
+    add_assoc_long(array, "bytesIn", totals->bytes_in);
+    add_assoc_long(array, "bytesOut", totals->bytes_out);
+    add_assoc_double(array, "time", (double)totals->nanoseconds / 1000000000.0); // Convert nanoseconds to seconds
+}
+
+// A batch of strings compressed or decompressed in a single call into Go,
+// with a preallocated output and a result slot per item
+typedef struct {
+    uint32_t count;
+    zend_string **items;
+    zend_string **outputs;
+    size_t *result_lens;
+    uintptr_t *pending;
+    char **errors;
+} zstd_batch;
+
+// Collects the strings of a batch and allocates their outputs up front, as
+// for a single compress or decompress call
+static bool batch_init(zstd_batch *batch, HashTable *items, bool compress, zend_long max_output)
+{
+    zval *item;
+    ZEND_HASH_FOREACH_VAL(items, item) {
+        ZVAL_DEREF(item);
+        if (Z_TYPE_P(item) != IS_STRING) {
+            zend_argument_type_error(1, "must contain only strings, %s given", zend_zval_type_name(item));
+            return false;
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    batch->count = zend_hash_num_elements(items);
+    batch->items = safe_emalloc(batch->count, sizeof(zend_string *), 0);
+    batch->outputs = ecalloc(batch->count, sizeof(zend_string *));
+    batch->result_lens = ecalloc(batch->count, sizeof(size_t));
+    batch->pending = ecalloc(batch->count, sizeof(uintptr_t));
+    batch->errors = ecalloc(batch->count, sizeof(char *));
+
+    uint32_t i = 0;
+    ZEND_HASH_FOREACH_VAL(items, item) {
+        ZVAL_DEREF(item);
+        batch->items[i++] = Z_STR_P(item);
+    } ZEND_HASH_FOREACH_END();
+
+    if (compress) {
+        for (i = 0; i < batch->count; i++) {
+            batch->outputs[i] = zend_string_alloc(FRANKEN_ZSTD_COMPRESS_BOUND(ZSTR_LEN(batch->items[i])), 0);
+        }
+        return true;
+    }
+
+    // Every output is sized in one call into Go, as alloc_decompressed()
+    // would one by one
+    int64_t *sizes = safe_emalloc(batch->count, sizeof(int64_t), 0);
+    go_decompressed_sizes(batch->items, batch->count, max_output, sizes);
+    for (i = 0; i < batch->count; i++) {
+        if (sizes[i] > 0) {
+            batch->outputs[i] = zend_string_alloc((size_t)sizes[i], 0);
+        }
+    }
+    efree(sizes);
+
+    return true;
+}
+
+static void batch_free(zstd_batch *batch)
+{
+    for (uint32_t i = 0; i < batch->count; i++) {
+        if (batch->outputs[i]) zend_string_efree(batch->outputs[i]);
+        if (batch->errors[i]) free(batch->errors[i]);
+    }
+    efree(batch->items);
+    efree(batch->outputs);
+    efree(batch->result_lens);
+    efree(batch->pending);
+    efree(batch->errors);
+}
+
+// Builds the result of a batch under the keys of the input array. An item
+// that failed gets a CompressionException instead of a string, so one bad
+// item does not discard the rest of the batch.
+static void return_batch_results(zval *return_value, HashTable *items, zstd_batch *batch, const char *failure)
+{
+    array_init_size(return_value, batch->count);
+
+    zend_ulong num_key;
+    zend_string *str_key;
+    uint32_t i = 0;
+    ZEND_HASH_FOREACH_KEY(items, num_key, str_key) {
+        zval result;
+        if (batch->errors[i]) {
+            zend_string *message = strpprintf(0, "%s: %s", failure, batch->errors[i]);
+            object_init_ex(&result, compression_exception_ce);
+            zend_update_property_str(zend_ce_exception, Z_OBJ(result), "message", sizeof("message") - 1, message);
+            zend_string_release(message);
+        } else {
+            return_go_result(&result, batch->outputs[i], batch->result_lens[i], batch->pending[i]);
+            batch->outputs[i] = NULL;
+        }
+
+        if (str_key) {
+            zend_hash_update(Z_ARRVAL_P(return_value), str_key, &result);
+        } else {
+            zend_hash_index_update(Z_ARRVAL_P(return_value), num_key, &result);
+        }
+        i++;
+    } ZEND_HASH_FOREACH_END();
+}
+
+// Validates the settings shared by every kind of Compressor, throwing on
+// the first invalid one
+static bool check_codec_options(zend_long window_size, zend_long dict_id, zend_long threads)
+{
+    if (window_size < 10 || window_size > 31) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Invalid window size: " ZEND_LONG_FMT " (must be 10-31)", window_size);
+        return false;
+    }
+
+    if (!check_dict_id(dict_id)) {
+        return false;
+    }
+
+    if (threads < 1 || threads > 256) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Invalid thread count: " ZEND_LONG_FMT " (must be 1-256)", threads);
+        return false;
+    }
+
+    return true;
+}
+
+// Validates the settings of Compressor::create and Compressor::persistent
+static bool check_compressor_options(zend_long level, zend_long window_size, zend_long dict_id, zend_long threads)
+{
+    if (level < 1 || level > 22) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Invalid compression level: " ZEND_LONG_FMT " (must be 1-22)", level);
+        return false;
+    }
+
+    return check_codec_options(window_size, dict_id, threads);
+}
+
+// Initializes return_value as a Compressor object with the given settings
+static compressor_object *init_compressor_object(zval *return_value, zend_long level, zend_long window_size, zend_long dict_id, zend_long threads)
+{
+    object_init_ex(return_value, compressor_ce);
+    compressor_object *obj = Z_COMPRESSOR_OBJ_P(return_value);
+
+    obj->level = (int)level;
+    obj->window_size = (int)window_size;
+    obj->dict_id = dict_id;
+    obj->threads = (int)threads;
+
+    return obj;
+}
+
+// Compressor::create
+ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, create)
+{
+    zend_long level = 3;
+    zend_long window_size = 22;
+    zend_long dict_id = 0;
+    zend_long threads = 1;
+
+    ZEND_PARSE_PARAMETERS_START(0, 4)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(level)
+        Z_PARAM_LONG(window_size)
+        Z_PARAM_LONG(dict_id)
+        Z_PARAM_LONG(threads)
+    ZEND_PARSE_PARAMETERS_END();
+
+    // Validate parameters
+    if (!check_compressor_options(level, window_size, dict_id, threads)) {
+        RETURN_THROWS();
+    }
+
+    // Create new compressor object
+    compressor_object *obj = init_compressor_object(return_value, level, window_size, dict_id, threads);
+
+    // Create the Go compressor and keep its registry handle
+    char *error = go_compressor_create(level, window_size, dict_id, threads, &obj->handle);
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Failed to create compressor: %s", error);
+        free(error);
+        RETURN_THROWS();
+    }
+}
+
+// Compressor::persistent
+ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, persistent)
+{
+    zend_string *name;
+    zend_long level = 3;
+    zend_long window_size = 22;
+    zend_long dict_id = 0;
+    zend_long threads = 1;
+
+    ZEND_PARSE_PARAMETERS_START(1, 5)
+        Z_PARAM_STR(name)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(level)
+        Z_PARAM_LONG(window_size)
+        Z_PARAM_LONG(dict_id)
+        Z_PARAM_LONG(threads)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (ZSTR_LEN(name) == 0) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Persistent compressor name must not be empty");
+        RETURN_THROWS();
+    }
+
+    if (!check_compressor_options(level, window_size, dict_id, threads)) {
+        RETURN_THROWS();
+    }
+
+    compressor_object *obj = init_compressor_object(return_value, level, window_size, dict_id, threads);
+    obj->persistent = true;
+
+    // The Go compressor outlives this object: it is created on first use of
+    // the name and shared by every later request and thread
+    char *error = go_compressor_persistent(name, level, window_size, dict_id, threads, &obj->handle);
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Failed to create compressor: %s", error);
+        free(error);
+        RETURN_THROWS();
+    }
+}
+
+// Compressor::adaptive
+ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, adaptive)
+{
+    double target_throughput;
+    zend_long window_size = 22;
+    zend_long dict_id = 0;
+    zend_long threads = 1;
+
+    ZEND_PARSE_PARAMETERS_START(1, 4)
+        Z_PARAM_DOUBLE(target_throughput)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(window_size)
+        Z_PARAM_LONG(dict_id)
+        Z_PARAM_LONG(threads)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_codec_options(window_size, dict_id, threads)) {
+        RETURN_THROWS();
+    }
+
+    // The level property is 0: the level is picked per input
+    compressor_object *obj = init_compressor_object(return_value, 0, window_size, dict_id, threads);
+
+    char *error = go_compressor_create_adaptive(target_throughput, window_size, dict_id, threads, &obj->handle);
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Failed to create compressor: %s", error);
+        free(error);
+        RETURN_THROWS();
+    }
+}
+
+// Compressor::compress
+ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, compress)
+{
+    zend_string *data;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_STR(data)
+    ZEND_PARSE_PARAMETERS_END();
+
+    compressor_object *obj = Z_COMPRESSOR_OBJ_P(ZEND_THIS);
+    
+    zend_string *result = zend_string_alloc(FRANKEN_ZSTD_COMPRESS_BOUND(ZSTR_LEN(data)), 0);
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+    
+    go_compressor_compress(obj->handle, data, result, &result_len, &pending, &error);
+    
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Compression failed: %s", error);
+        free(error);
+        if (result) zend_string_efree(result);
+        RETURN_THROWS();
+    }
+    
+    return_go_result(return_value, result, result_len, pending);
+}
+
+// Compressor::decompress
+ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, decompress)
+{
+    zend_string *compressed_data;
+    zend_long max_output = 0;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_STR(compressed_data)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(max_output)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_max_output(max_output)) {
+        RETURN_THROWS();
+    }
+
+    compressor_object *obj = Z_COMPRESSOR_OBJ_P(ZEND_THIS);
+    
+    zend_string *result = alloc_decompressed(compressed_data, max_output);
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+    
+    go_compressor_decompress(obj->handle, compressed_data, max_output, result, &result_len, &pending, &error);
+    
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Decompression failed: %s", error);
+        free(error);
+        if (result) zend_string_efree(result);
+        RETURN_THROWS();
+    }
+    
+    return_go_result(return_value, result, result_len, pending);
+}
+
+// Compressor::compressMany
+ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, compressMany)
+{
+    HashTable *items;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_ARRAY_HT(items)
+    ZEND_PARSE_PARAMETERS_END();
+
+    compressor_object *obj = Z_COMPRESSOR_OBJ_P(ZEND_THIS);
+
+    zstd_batch batch;
+    if (!batch_init(&batch, items, true, 0)) {
+        RETURN_THROWS();
+    }
+
+    char *error = go_compressor_compress_many(obj->handle, batch.items, batch.outputs, batch.count, batch.result_lens, batch.pending, batch.errors);
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Compression failed: %s", error);
+        free(error);
+        batch_free(&batch);
+        RETURN_THROWS();
+    }
+
+    return_batch_results(return_value, items, &batch, "Compression failed");
+    batch_free(&batch);
+}
+
+// Compressor::decompressMany
+ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, decompressMany)
+{
+    HashTable *items;
+    zend_long max_output = 0;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_ARRAY_HT(items)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(max_output)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_max_output(max_output)) {
+        RETURN_THROWS();
+    }
+
+    compressor_object *obj = Z_COMPRESSOR_OBJ_P(ZEND_THIS);
+
+    zstd_batch batch;
+    if (!batch_init(&batch, items, false, max_output)) {
+        RETURN_THROWS();
+    }
+
+    char *error = go_compressor_decompress_many(obj->handle, batch.items, batch.outputs, batch.count, max_output, batch.result_lens, batch.pending, batch.errors);
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Decompression failed: %s", error);
+        free(error);
+        batch_free(&batch);
+        RETURN_THROWS();
+    }
+
+    return_batch_results(return_value, items, &batch, "Decompression failed");
+    batch_free(&batch);
+}
+
+// Compressor::getStats
+ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, getStats)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    compressor_object *obj = Z_COMPRESSOR_OBJ_P(ZEND_THIS);
+    
+    zend_long original_size, compressed_size, compression_time;
+    double compression_ratio;
+    franken_zstd_totals compress_totals, decompress_totals;
+    char *error = NULL;
+    
+    go_compressor_get_stats(obj->handle, &original_size, &compressed_size, &compression_ratio, &compression_time, &compress_totals, &decompress_totals, &error);
+    
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Failed to get stats: %s", error);
+        free(error);
+        RETURN_THROWS();
+    }
+    
+    array_init(return_value);
+    add_assoc_long(return_value, "originalSize", original_size);
+    add_assoc_long(return_value, "compressedSize", compressed_size);
+    add_assoc_double(return_value, "compressionRatio", compression_ratio);
+    add_assoc_double(return_value, "compressionTime", (double)compression_time / 1000000000.0); // Convert nanoseconds to seconds
+
+    zval totals;
+    totals_to_array(&totals, &compress_totals);
+    add_assoc_zval(return_value, "compress", &totals);
+    totals_to_array(&totals, &decompress_totals);
+    add_assoc_zval(return_value, "decompress", &totals);
+
+    // Level currently picked for each input size class
+    double target;
+    int64_t min_sizes[FRANKEN_ZSTD_ADAPTIVE_CLASSES], levels[FRANKEN_ZSTD_ADAPTIVE_CLASSES];
+    double throughput[FRANKEN_ZSTD_ADAPTIVE_CLASSES];
+    if (go_compressor_get_adaptive(obj->handle, &target, min_sizes, levels, throughput)) {
+        zval adaptive, classes, class;
+        array_init(&adaptive);
+        add_assoc_double(&adaptive, "target", target);
+        array_init_size(&classes, FRANKEN_ZSTD_ADAPTIVE_CLASSES);
+        for (int i = 0; i < FRANKEN_ZSTD_ADAPTIVE_CLASSES; i++) {
+            array_init(&class);
+            add_assoc_long(&class, "minSize", min_sizes[i]);
+            add_assoc_long(&class, "level", levels[i]);
+            add_assoc_double(&class, "throughput", throughput[i]);
+            add_next_index_zval(&classes, &class);
+        }
+        add_assoc_zval(&adaptive, "classes", &classes);
+        add_assoc_zval(return_value, "adaptive", &adaptive);
+    }
+}
+
+// Compressor::close
+ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, close)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    compressor_object *obj = Z_COMPRESSOR_OBJ_P(ZEND_THIS);
+    
+    // A persistent compressor stays open for other requests; only this
+    // object lets go of it
+    if (obj->handle && !obj->persistent) {
+        char *error = go_compressor_close(obj->handle);
+        if (error) {
+            zend_throw_exception_ex(compression_exception_ce, 0, "Failed to close compressor: %s", error);
+            free(error);
+            RETURN_THROWS();
+        }
+        
+        obj->handle = 0;
+    }
+}
+
+// StreamCompressor::create
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamCompressor, create)
+{
+    zend_long level = 3;
+    zend_long window_size = 22;
+    zend_long dict_id = 0;
+
+    ZEND_PARSE_PARAMETERS_START(0, 3)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(level)
+        Z_PARAM_LONG(window_size)
+        Z_PARAM_LONG(dict_id)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_dict_id(dict_id)) {
+        RETURN_THROWS();
+    }
+
+    object_init_ex(return_value, stream_compressor_ce);
+    stream_object *obj = Z_STREAM_OBJ_P(return_value);
+
+    char *error = go_stream_compressor_create(level, window_size, dict_id, &obj->handle);
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Failed to create stream compressor: %s", error);
+        free(error);
+        RETURN_THROWS();
+    }
+}
+
+// StreamCompressor::write
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamCompressor, write)
+{
+    zend_string *data;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_STR(data)
+    ZEND_PARSE_PARAMETERS_END();
+
+    stream_object *obj = Z_STREAM_OBJ_P(ZEND_THIS);
+    
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+    
+    go_stream_compressor_write(obj->handle, ZSTR_VAL(data), ZSTR_LEN(data), &result_len, &pending, &error);
+    
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Compression failed: %s", error);
+        free(error);
+        RETURN_THROWS();
+    }
+    
+    return_go_result(return_value, NULL, result_len, pending);
+}
+
+// StreamCompressor::flush
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamCompressor, flush)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    stream_object *obj = Z_STREAM_OBJ_P(ZEND_THIS);
+    
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+    
+    go_stream_compressor_flush(obj->handle, &result_len, &pending, &error);
+    
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Compression failed: %s", error);
+        free(error);
+        RETURN_THROWS();
+    }
+    
+    return_go_result(return_value, NULL, result_len, pending);
+}
+
+// StreamCompressor::finish
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamCompressor, finish)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    stream_object *obj = Z_STREAM_OBJ_P(ZEND_THIS);
+    
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+    
+    go_stream_compressor_finish(obj->handle, &result_len, &pending, &error);
+    
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Compression failed: %s", error);
+        free(error);
+        RETURN_THROWS();
+    }
+    
+    return_go_result(return_value, NULL, result_len, pending);
+}
+
+// StreamCompressor::close
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamCompressor, close)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    stream_object *obj = Z_STREAM_OBJ_P(ZEND_THIS);
+    
+    if (obj->handle) {
+        char *error = go_stream_compressor_close(obj->handle);
+        if (error) {
+            zend_throw_exception_ex(compression_exception_ce, 0, "Failed to close stream: %s", error);
+            free(error);
+            RETURN_THROWS();
+        }
+        
+        obj->handle = 0;
+    }
+}
+
+// StreamDecompressor::create
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamDecompressor, create)
+{
+    zend_long max_window_size = 27;
+
+    ZEND_PARSE_PARAMETERS_START(0, 1)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(max_window_size)
+    ZEND_PARSE_PARAMETERS_END();
+
+    object_init_ex(return_value, stream_decompressor_ce);
+    stream_object *obj = Z_STREAM_OBJ_P(return_value);
+
+    char *error = go_stream_decompressor_create(max_window_size, &obj->handle);
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Failed to create stream decompressor: %s", error);
+        free(error);
+        RETURN_THROWS();
+    }
+}
+
+// Validates the output cap of a stream decompressor call
+static bool check_max_length(zend_long max_length)
+{
+    if (max_length < 0) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Invalid maximum length: " ZEND_LONG_FMT " (must be 0 or more)", max_length);
+        return false;
+    }
+    return true;
+}
+
+// StreamDecompressor::write
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamDecompressor, write)
+{
+    zend_string *data;
+    zend_long max_length = 0;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_STR(data)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(max_length)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_max_length(max_length)) {
+        RETURN_THROWS();
+    }
+
+    stream_object *obj = Z_STREAM_OBJ_P(ZEND_THIS);
+    
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+    
+    go_stream_decompressor_write(obj->handle, ZSTR_VAL(data), ZSTR_LEN(data), max_length, &result_len, &pending, &error);
+    
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Decompression failed: %s", error);
+        free(error);
+        RETURN_THROWS();
+    }
+    
+    return_go_result(return_value, NULL, result_len, pending);
+}
+
+// StreamDecompressor::read
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamDecompressor, read)
+{
+    zend_long max_length = 0;
+
+    ZEND_PARSE_PARAMETERS_START(0, 1)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(max_length)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_max_length(max_length)) {
+        RETURN_THROWS();
+    }
+
+    stream_object *obj = Z_STREAM_OBJ_P(ZEND_THIS);
+    
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+    
+    go_stream_decompressor_read(obj->handle, max_length, &result_len, &pending, &error);
+    
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Decompression failed: %s", error);
+        free(error);
+        RETURN_THROWS();
+    }
+    
+    return_go_result(return_value, NULL, result_len, pending);
+}
+
+// StreamDecompressor::finish
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamDecompressor, finish)
+{
+    zend_long max_length = 0;
+
+    ZEND_PARSE_PARAMETERS_START(0, 1)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(max_length)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_max_length(max_length)) {
+        RETURN_THROWS();
+    }
+
+    stream_object *obj = Z_STREAM_OBJ_P(ZEND_THIS);
+    
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+    
+    go_stream_decompressor_finish(obj->handle, max_length, &result_len, &pending, &error);
+    
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Decompression failed: %s", error);
+        free(error);
+        RETURN_THROWS();
+    }
+    
+    return_go_result(return_value, NULL, result_len, pending);
+}
+
+// StreamDecompressor::close
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamDecompressor, close)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    stream_object *obj = Z_STREAM_OBJ_P(ZEND_THIS);
+    
+    if (obj->handle) {
+        char *error = go_stream_decompressor_close(obj->handle);
+        if (error) {
+            zend_throw_exception_ex(compression_exception_ce, 0, "Failed to close stream: %s", error);
+            free(error);
+            RETURN_THROWS();
+        }
+        
+        obj->handle = 0;
+    }
+}
+
+// Waits for the result of a future and keeps it in the object, so it can be
+// read more than once
+static void future_collect(future_object *obj)
+{
+    if (!obj->handle) {
+        return;
+    }
+
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+
+    go_future_wait(obj->handle, &result_len, &pending, &error);
+    obj->handle = 0;
+
+    if (error) {
+        obj->error = strpprintf(0, "%s: %s", obj->failure, error);
+        free(error);
+        if (obj->output) zend_string_efree(obj->output);
+    } else {
+        zval result;
+        return_go_result(&result, obj->output, result_len, pending);
+        obj->result = Z_STR(result);
+    }
+    obj->output = NULL;
+
+    zend_string_release(obj->input);
+    obj->input = NULL;
+}
+
+// Future::wait
+ZEND_METHOD(Phillarmonic_FrankenZstd_Future, wait)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    future_object *obj = Z_FUTURE_OBJ_P(ZEND_THIS);
+    future_collect(obj);
+
+    if (obj->error) {
+        zend_throw_exception(compression_exception_ce, ZSTR_VAL(obj->error), 0);
+        RETURN_THROWS();
+    }
+    if (!obj->result) {
+        zend_throw_exception(compression_exception_ce, "Future was not started by compressAsync() or decompressAsync()", 0);
+        RETURN_THROWS();
+    }
+
+    RETURN_STR_COPY(obj->result);
+}
+
+// Future::isReady
+ZEND_METHOD(Phillarmonic_FrankenZstd_Future, isReady)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    future_object *obj = Z_FUTURE_OBJ_P(ZEND_THIS);
+    RETURN_BOOL(!obj->handle || go_future_ready(obj->handle));
+}
+
+// Future::waitAll
+ZEND_METHOD(Phillarmonic_FrankenZstd_Future, waitAll)
+{
+    HashTable *futures;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_ARRAY_HT(futures)
+    ZEND_PARSE_PARAMETERS_END();
+
+    zval *future;
+    ZEND_HASH_FOREACH_VAL(futures, future) {
+        ZVAL_DEREF(future);
+        if (Z_TYPE_P(future) != IS_OBJECT || !instanceof_function(Z_OBJCE_P(future), future_ce)) {
+            zend_argument_type_error(1, "must contain only Phillarmonic\\FrankenZstd\\Future objects, %s given", zend_zval_type_name(future));
+            RETURN_THROWS();
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    // Every future already runs, so collecting them in order waits for the
+    // slowest one only
+    array_init_size(return_value, zend_hash_num_elements(futures));
+
+    zend_ulong num_key;
+    zend_string *str_key;
+    ZEND_HASH_FOREACH_KEY_VAL(futures, num_key, str_key, future) {
+        ZVAL_DEREF(future);
+        future_object *obj = Z_FUTURE_OBJ_P(future);
+        future_collect(obj);
+
+        zval result;
+        if (obj->result) {
+            ZVAL_STR_COPY(&result, obj->result);
+        } else {
+            object_init_ex(&result, compression_exception_ce);
+            zend_update_property_string(zend_ce_exception, Z_OBJ(result), "message", sizeof("message") - 1,
+                obj->error ? ZSTR_VAL(obj->error) : "Future was not started by compressAsync() or decompressAsync()");
+        }
+
+        if (str_key) {
+            zend_hash_update(Z_ARRVAL_P(return_value), str_key, &result);
+        } else {
+            zend_hash_index_update(Z_ARRVAL_P(return_value), num_key, &result);
+        }
+    } ZEND_HASH_FOREACH_END();
+}
+
+// Quick compress function
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_compress)
+{
+    zend_string *data;
+    zend_long level = 3;
+    zend_long dict_id = 0;
+
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        Z_PARAM_STR(data)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(level)
+        Z_PARAM_LONG(dict_id)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_dict_id(dict_id)) {
+        RETURN_THROWS();
+    }
+
+    zend_string *result = zend_string_alloc(FRANKEN_ZSTD_COMPRESS_BOUND(ZSTR_LEN(data)), 0);
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+    
+    go_quick_compress(data, level, dict_id, result, &result_len, &pending, &error);
+    
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Compression failed: %s", error);
+        free(error);
+        if (result) zend_string_efree(result);
+        RETURN_THROWS();
+    }
+    
+    return_go_result(return_value, result, result_len, pending);
+}
+
+// Quick decompress function
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_decompress)
+{
+    zend_string *compressed_data;
+    zend_long max_output = 0;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_STR(compressed_data)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(max_output)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_max_output(max_output)) {
+        RETURN_THROWS();
+    }
+
+    zend_string *result = alloc_decompressed(compressed_data, max_output);
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+    
+    go_quick_decompress(compressed_data, max_output, result, &result_len, &pending, &error);
+    
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Decompression failed: %s", error);
+        free(error);
+        if (result) zend_string_efree(result);
+        RETURN_THROWS();
+    }
+    
+    return_go_result(return_value, result, result_len, pending);
+}
+
+// Quick batch compress function
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_compressMany)
+{
+    HashTable *items;
+    zend_long level = 3;
+    zend_long dict_id = 0;
+
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        Z_PARAM_ARRAY_HT(items)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(level)
+        Z_PARAM_LONG(dict_id)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_dict_id(dict_id)) {
+        RETURN_THROWS();
+    }
+
+    zstd_batch batch;
+    if (!batch_init(&batch, items, true, 0)) {
+        RETURN_THROWS();
+    }
+
+    char *error = go_quick_compress_many(batch.items, batch.outputs, batch.count, level, dict_id, batch.result_lens, batch.pending, batch.errors);
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Compression failed: %s", error);
+        free(error);
+        batch_free(&batch);
+        RETURN_THROWS();
+    }
+
+    return_batch_results(return_value, items, &batch, "Compression failed");
+    batch_free(&batch);
+}
+
+// Quick batch decompress function
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_decompressMany)
+{
+    HashTable *items;
+    zend_long max_output = 0;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_ARRAY_HT(items)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(max_output)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_max_output(max_output)) {
+        RETURN_THROWS();
+    }
+
+    zstd_batch batch;
+    if (!batch_init(&batch, items, false, max_output)) {
+        RETURN_THROWS();
+    }
+
+    go_quick_decompress_many(batch.items, batch.outputs, batch.count, max_output, batch.result_lens, batch.pending, batch.errors);
+
+    return_batch_results(return_value, items, &batch, "Decompression failed");
+    batch_free(&batch);
+}
+
+// Delta compress function
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_compressDelta)
+{
+    zend_string *reference;
+    zend_string *data;
+    zend_long level = 3;
+
+    ZEND_PARSE_PARAMETERS_START(2, 3)
+        Z_PARAM_STR(reference)
+        Z_PARAM_STR(data)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(level)
+    ZEND_PARSE_PARAMETERS_END();
+
+    zend_string *result = zend_string_alloc(FRANKEN_ZSTD_COMPRESS_BOUND(ZSTR_LEN(data)), 0);
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+
+    go_compress_delta(reference, data, level, result, &result_len, &pending, &error);
+
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Compression failed: %s", error);
+        free(error);
+        zend_string_efree(result);
+        RETURN_THROWS();
+    }
+
+    return_go_result(return_value, result, result_len, pending);
+}
+
+// Delta decompress function
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_decompressDelta)
+{
+    zend_string *reference;
+    zend_string *patch;
+
+    ZEND_PARSE_PARAMETERS_START(2, 2)
+        Z_PARAM_STR(reference)
+        Z_PARAM_STR(patch)
+    ZEND_PARSE_PARAMETERS_END();
+
+    zend_string *result = alloc_decompressed(patch, 0);
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+
+    go_decompress_delta(reference, patch, result, &result_len, &pending, &error);
+
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Decompression failed: %s", error);
+        free(error);
+        if (result) zend_string_efree(result);
+        RETURN_THROWS();
+    }
+
+    return_go_result(return_value, result, result_len, pending);
+}
+
+// Resolves a path against the PHP working directory, which Go does not
+// share, and checks it against open_basedir. Throws on failure.
+static bool resolve_file_path(const char *path, char *resolved)
+{
+    if (!expand_filepath(path, resolved)) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Invalid path: %s", path);
+        return false;
+    }
+
+    if (php_check_open_basedir_ex(resolved, 0)) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Path not allowed by open_basedir: %s", path);
+        return false;
+    }
+
+    return true;
+}
+
+// Builds the stats array of a file compression or decompression
+static void return_file_stats(zval *return_value, int64_t original_size, int64_t compressed_size, int64_t bytes_in, int64_t bytes_out, int64_t nanoseconds)
+{
+    array_init(return_value);
+    add_assoc_long(return_value, "bytesIn", bytes_in);
+    add_assoc_long(return_value, "bytesOut", bytes_out);
+    add_assoc_double(return_value, "compressionRatio", compressed_size > 0 ? (double)original_size / (double)compressed_size : 0.0);
+    add_assoc_double(return_value, "time", (double)nanoseconds / 1000000000.0); // Convert nanoseconds to seconds
+}
+
+// File to file compress function. The data stays in Go from end to end.
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_compressFile)
+{
+    char *source, *destination;
+    size_t source_len, destination_len;
+    zend_long level = 3;
+    zend_long dict_id = 0;
+    zend_long threads = 1;
+
+    ZEND_PARSE_PARAMETERS_START(2, 5)
+        Z_PARAM_PATH(source, source_len)
+        Z_PARAM_PATH(destination, destination_len)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(level)
+        Z_PARAM_LONG(dict_id)
+        Z_PARAM_LONG(threads)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_dict_id(dict_id)) {
+        RETURN_THROWS();
+    }
+
+    char resolved_source[MAXPATHLEN], resolved_destination[MAXPATHLEN];
+    if (!resolve_file_path(source, resolved_source) || !resolve_file_path(destination, resolved_destination)) {
+        RETURN_THROWS();
+    }
+
+    int64_t bytes_in = 0, bytes_out = 0, nanoseconds = 0;
+    char *error = go_compress_file(resolved_source, resolved_destination, level, dict_id, threads, &bytes_in, &bytes_out, &nanoseconds);
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Compression failed: %s", error);
+        free(error);
+        RETURN_THROWS();
+    }
+
+    return_file_stats(return_value, bytes_in, bytes_out, bytes_in, bytes_out, nanoseconds);
+}
+
+// File to file decompress function
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_decompressFile)
+{
+    char *source, *destination;
+    size_t source_len, destination_len;
+    zend_long max_output = 0;
+
+    ZEND_PARSE_PARAMETERS_START(2, 3)
+        Z_PARAM_PATH(source, source_len)
+        Z_PARAM_PATH(destination, destination_len)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(max_output)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_max_output(max_output)) {
+        RETURN_THROWS();
+    }
+
+    char resolved_source[MAXPATHLEN], resolved_destination[MAXPATHLEN];
+    if (!resolve_file_path(source, resolved_source) || !resolve_file_path(destination, resolved_destination)) {
+        RETURN_THROWS();
+    }
+
+    int64_t bytes_in = 0, bytes_out = 0, nanoseconds = 0;
+    char *error = go_decompress_file(resolved_source, resolved_destination, max_output, &bytes_in, &bytes_out, &nanoseconds);
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Decompression failed: %s", error);
+        free(error);
+        RETURN_THROWS();
+    }
+
+    return_file_stats(return_value, bytes_out, bytes_in, bytes_in, bytes_out, nanoseconds);
+}
+
+// Starts a future on data with a preallocated output
+static void return_future(zval *return_value, zend_string *data, zend_string *output, const char *failure)
+{
+    object_init_ex(return_value, future_ce);
+    future_object *obj = Z_FUTURE_OBJ_P(return_value);
+
+    obj->input = zend_string_copy(data);
+    obj->output = output;
+    obj->failure = failure;
+}
+
+// Async compress function
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_compressAsync)
+{
+    zend_string *data;
+    zend_long level = 3;
+    zend_long dict_id = 0;
+
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        Z_PARAM_STR(data)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(level)
+        Z_PARAM_LONG(dict_id)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_dict_id(dict_id)) {
+        RETURN_THROWS();
+    }
+
+    return_future(return_value, data, zend_string_alloc(FRANKEN_ZSTD_COMPRESS_BOUND(ZSTR_LEN(data)), 0), "Compression failed");
+    future_object *obj = Z_FUTURE_OBJ_P(return_value);
+
+    char *error = go_compress_async(obj->input, level, dict_id, obj->output, &obj->handle);
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Compression failed: %s", error);
+        free(error);
+        zval_ptr_dtor(return_value);
+        RETURN_THROWS();
+    }
+}
+
+// Async decompress function
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_decompressAsync)
+{
+    zend_string *compressed_data;
+    zend_long max_output = 0;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_STR(compressed_data)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(max_output)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_max_output(max_output)) {
+        RETURN_THROWS();
+    }
+
+    return_future(return_value, compressed_data, alloc_decompressed(compressed_data, max_output), "Decompression failed");
+    future_object *obj = Z_FUTURE_OBJ_P(return_value);
+
+    char *error = go_decompress_async(obj->input, max_output, obj->output, &obj->handle);
+    if (error) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Decompression failed: %s", error);
+        free(error);
+        zval_ptr_dtor(return_value);
+        RETURN_THROWS();
+    }
+}
+
+// Checks whether the response can be compressed: headers not sent yet and
+// zstd allowed by the Accept-Encoding of the request
+static bool output_accepts_zstd(void)
+{
+    if (SG(headers_sent) || SG(request_info).no_headers) {
+        return false;
+    }
+
+    zend_is_auto_global_str(ZEND_STRL("_SERVER"));
+    zval *server = &PG(http_globals)[TRACK_VARS_SERVER];
+    zval *accept = Z_TYPE_P(server) == IS_ARRAY
+        ? zend_hash_str_find(Z_ARRVAL_P(server), ZEND_STRL("HTTP_ACCEPT_ENCODING"))
+        : NULL;
+    return accept && Z_TYPE_P(accept) == IS_STRING && go_output_accepts_zstd(Z_STRVAL_P(accept), Z_STRLEN_P(accept));
+}
+
+// Removes a header set by the script or by the handler
+static void output_remove_header(const char *name, size_t name_len)
+{
+    sapi_header_line line = {0};
+    line.line = (char *) name;
+    line.line_len = name_len;
+    sapi_header_op(SAPI_HEADER_DELETE, &line);
+}
+
+// Announces the encoding, and that caches must key the response on it; a
+// length set by the script would be the uncompressed one
+static void output_set_encoding(void)
+{
+    output_remove_header(ZEND_STRL("Content-Length"));
+    sapi_add_header_ex(ZEND_STRL("Vary: Accept-Encoding"), 1, 0);
+    sapi_add_header_ex(ZEND_STRL("Content-Encoding: zstd"), 1, 1);
+}
+
+// Releases the stream of the output handler
+static void output_stop(void)
+{
+    if (ZSTD_G(ob_handle)) {
+        char *error = go_stream_compressor_close(ZSTD_G(ob_handle));
+        if (error) free(error);
+        ZSTD_G(ob_handle) = 0;
+    }
+    ZSTD_G(ob_sent) = false;
+}
+
+#define OUTPUT_HANDLER_NAME "Phillarmonic\\FrankenZstd\\ob_handler"
 
-// Compressor::create
-ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, create)
+// Refuses to start the handler a second time, which would share the stream
+// of the first, or on top of another compressing handler, as ob_gzhandler
+// does
+static int output_conflict_check(const char *handler_name, size_t handler_name_len)
 {
-    zend_long level = 3;
-    zend_long window_size = 22;
+    if (php_output_get_level() > 0) {
+        if (php_output_handler_conflict(handler_name, handler_name_len, ZEND_STRL(OUTPUT_HANDLER_NAME))
+            || php_output_handler_conflict(handler_name, handler_name_len, ZEND_STRL("ob_gzhandler"))
+            || php_output_handler_conflict(handler_name, handler_name_len, ZEND_STRL("zlib output compression"))) {
+            return FAILURE;
+        }
+    }
+    return SUCCESS;
+}
 
-    ZEND_PARSE_PARAMETERS_START(0, 2)
-        Z_PARAM_OPTIONAL
-        Z_PARAM_LONG(level)
-        Z_PARAM_LONG(window_size)
+// Output buffer handler, for ob_start(). Returning false disables it for
+// the rest of the buffer, which then passes through uncompressed; that is
+// only done while the response is not or no longer announced as zstd.
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_ob_handler)
+{
+    zend_string *buffer;
+    zend_long phase;
+
+    ZEND_PARSE_PARAMETERS_START(2, 2)
+        Z_PARAM_STR(buffer)
+        Z_PARAM_LONG(phase)
     ZEND_PARSE_PARAMETERS_END();
 
-    // Validate parameters
-    if (level < 1 || level > 22) {
-        zend_throw_exception_ex(compression_exception_ce, 0, "Invalid compression level: " ZEND_LONG_FMT " (must be 1-22)", level);
-        RETURN_THROWS();
+    bool finish = (phase & PHP_OUTPUT_HANDLER_FINAL) != 0;
+
+    if (phase & PHP_OUTPUT_HANDLER_START) {
+        // A second instance the conflict check missed, e.g. started under
+        // another spelling of the name: its output passes through to the
+        // instance already compressing
+        if (ZSTD_G(ob_handle) || ZSTD_G(ob_failed)) {
+            php_error_docref(NULL, E_WARNING, "Output handler '%s' cannot be used twice", OUTPUT_HANDLER_NAME);
+            RETURN_FALSE;
+        }
+        if (!output_accepts_zstd()) {
+            RETURN_FALSE;
+        }
+
+        char *error = go_output_start(&ZSTD_G(ob_handle));
+        if (error) {
+            php_error_docref(NULL, E_WARNING, "Failed to create output compressor: %s", error);
+            free(error);
+            RETURN_FALSE;
+        }
+        output_set_encoding();
     }
-    
-    if (window_size < 10 || window_size > 31) {
-        zend_throw_exception_ex(compression_exception_ce, 0, "Invalid window size: " ZEND_LONG_FMT " (must be 10-31)", window_size);
-        RETURN_THROWS();
+
+    // The client was promised zstd, so output after a failure is dropped
+    // rather than sent uncompressed behind the bytes already sent
+    if (ZSTD_G(ob_failed)) {
+        if (finish) {
+            ZSTD_G(ob_failed) = false;
+        }
+        RETURN_EMPTY_STRING();
     }
 
-    // Create new compressor object
-    object_init_ex(return_value, compressor_ce);
-    compressor_object *obj = Z_COMPRESSOR_OBJ_P(return_value);
-    
-    // Generate unique name for this compressor instance
-    char name_buf[64];
-    snprintf(name_buf, sizeof(name_buf), "compressor_%p", (void*)obj);
-    obj->name = zend_string_init(name_buf, strlen(name_buf), 0);
-    obj->level = (int)level;
-    obj->window_size = (int)window_size;
+    if (!ZSTD_G(ob_handle)) {
+        RETURN_FALSE;
+    }
+
+    // Cleaned output is discarded, and so is whatever the handler returns
+    // for it. Once the buffer is discarded whole, or before any compressed
+    // byte left the handler, the response goes out uncompressed, as with
+    // ob_gzhandler; otherwise the frame restarts without the cleaned data.
+    if (phase & PHP_OUTPUT_HANDLER_CLEAN) {
+        if (finish || !ZSTD_G(ob_sent)) {
+            output_stop();
+            if (!SG(headers_sent)) {
+                output_remove_header(ZEND_STRL("Content-Encoding"));
+            }
+            RETURN_FALSE;
+        }
+
+        char *error = go_output_reset(ZSTD_G(ob_handle));
+        if (error) {
+            php_error_docref(NULL, E_WARNING, "Compression failed: %s", error);
+            free(error);
+            output_stop();
+            ZSTD_G(ob_failed) = true;
+        }
+        RETURN_EMPTY_STRING();
+    }
+
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+
+    go_output_write(ZSTD_G(ob_handle), ZSTR_VAL(buffer), ZSTR_LEN(buffer), (phase & PHP_OUTPUT_HANDLER_FLUSH) != 0, finish, &result_len, &pending, &error);
+    if (finish) {
+        output_stop();
+    }
 
-    // Create the Go compressor
-    char *error = go_compressor_create(obj->name, level, window_size);
     if (error) {
-        zend_throw_exception_ex(compression_exception_ce, 0, "Failed to create compressor: %s", error);
+        php_error_docref(NULL, E_WARNING, "Compression failed: %s", error);
         free(error);
-        RETURN_THROWS();
+        output_stop();
+        ZSTD_G(ob_failed) = !finish;
+        if (!SG(headers_sent)) {
+            SG(sapi_headers).http_response_code = 500;
+        }
+        RETURN_EMPTY_STRING();
+    }
+
+    if (result_len > 0 && !finish) {
+        ZSTD_G(ob_sent) = true;
     }
+    return_go_result(return_value, NULL, result_len, pending);
 }
 
-// Compressor::compress
-ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, compress)
+// Seekable compress function
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_compressSeekable)
 {
     zend_string *data;
+    zend_long level = 3;
+    zend_long frame_size = 1048576;
 
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    ZEND_PARSE_PARAMETERS_START(1, 3)
         Z_PARAM_STR(data)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(level)
+        Z_PARAM_LONG(frame_size)
     ZEND_PARSE_PARAMETERS_END();
 
-    compressor_object *obj = Z_COMPRESSOR_OBJ_P(ZEND_THIS);
-    
-    char *result, *error;
-    int result_len;
-    result = NULL;
-    error = NULL;
-    
-    go_compressor_compress(obj->name, data, &result, &result_len, &error);
-    
+    if (frame_size < 1024 || frame_size > (1 << 30)) {
+        zend_throw_exception_ex(compression_exception_ce, 0, "Invalid frame size: " ZEND_LONG_FMT " (must be 1024-1073741824)", frame_size);
+        RETURN_THROWS();
+    }
+
+    zend_string *result = zend_string_alloc(FRANKEN_ZSTD_SEEKABLE_BOUND(ZSTR_LEN(data), (size_t)frame_size), 0);
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+
+    go_compress_seekable(data, level, frame_size, result, &result_len, &pending, &error);
+
     if (error) {
         zend_throw_exception_ex(compression_exception_ce, 0, "Compression failed: %s", error);
         free(error);
-        if (result) free(result);
+        zend_string_efree(result);
         RETURN_THROWS();
     }
-    
-    if (result) {
-        RETVAL_STRINGL(result, result_len);
-        free(result);
-    } else {
-        RETURN_EMPTY_STRING();
-    }
+
+    return_go_result(return_value, result, result_len, pending);
 }
 
-// Compressor::decompress
-ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, decompress)
+// Decompress a range of a seekable payload
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_decompressRange)
 {
-    zend_string *compressed_data;
+    zend_string *data;
+    zend_long offset;
+    zend_long length;
 
-    ZEND_PARSE_PARAMETERS_START(1, 1)
-        Z_PARAM_STR(compressed_data)
+    ZEND_PARSE_PARAMETERS_START(3, 3)
+        Z_PARAM_STR(data)
+        Z_PARAM_LONG(offset)
+        Z_PARAM_LONG(length)
     ZEND_PARSE_PARAMETERS_END();
 
-    compressor_object *obj = Z_COMPRESSOR_OBJ_P(ZEND_THIS);
-    
-    char *result, *error;
-    int result_len;
-    result = NULL;
-    error = NULL;
-    
-    go_compressor_decompress(obj->name, compressed_data, &result, &result_len, &error);
-    
+    // Size the output from the seek table; Go reports invalid ranges
+    zend_string *result = NULL;
+    int64_t size = go_seekable_size(data);
+    if (offset >= 0 && length > 0 && size > offset) {
+        result = zend_string_alloc((size_t)MIN(length, size - offset), 0);
+    }
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
+
+    go_decompress_range(data, offset, length, result, &result_len, &pending, &error);
+
     if (error) {
         zend_throw_exception_ex(compression_exception_ce, 0, "Decompression failed: %s", error);
         free(error);
-        if (result) free(result);
+        if (result) zend_string_efree(result);
         RETURN_THROWS();
     }
-    
-    if (result) {
-        RETVAL_STRINGL(result, result_len);
-        free(result);
-    } else {
-        RETURN_EMPTY_STRING();
-    }
+
+    return_go_result(return_value, result, result_len, pending);
 }
 
-// Compressor::getStats
-ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, getStats)
+// Train a dictionary from sample strings
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_trainDictionary)
 {
-    ZEND_PARSE_PARAMETERS_NONE();
+    HashTable *samples;
+    zend_long dict_id = 0;
+    zend_long max_size = 112640;
 
-    compressor_object *obj = Z_COMPRESSOR_OBJ_P(ZEND_THIS);
-    
-    zend_long original_size, compressed_size, compression_time;
-    double compression_ratio;
-    char *error = NULL;
-    
-    go_compressor_get_stats(obj->name, &original_size, &compressed_size, &compression_ratio, &compression_time, &error);
-    
-    if (error) {
-        zend_throw_exception_ex(compression_exception_ce, 0, "Failed to get stats: %s", error);
-        free(error);
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        Z_PARAM_ARRAY_HT(samples)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(dict_id)
+        Z_PARAM_LONG(max_size)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!check_dict_id(dict_id)) {
         RETURN_THROWS();
     }
-    
-    array_init(return_value);
-    add_assoc_long(return_value, "originalSize", original_size);
-    add_assoc_long(return_value, "compressedSize", compressed_size);
-    add_assoc_double(return_value, "compressionRatio", compression_ratio);
-    add_assoc_double(return_value, "compressionTime", (double)compression_time / 1000000000.0); // Convert nanoseconds to seconds
-}
-
-// Compressor::close
-ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, close)
-{
-    ZEND_PARSE_PARAMETERS_NONE();
 
-    compressor_object *obj = Z_COMPRESSOR_OBJ_P(ZEND_THIS);
-    
-    if (obj->name) {
-        char *error = go_compressor_close(obj->name);
-        if (error) {
-            zend_throw_exception_ex(compression_exception_ce, 0, "Failed to close compressor: %s", error);
-            free(error);
+    // Hand Go the sample zend_strings themselves so it reads them in place
+    uint32_t count = zend_hash_num_elements(samples);
+    zend_string **sample_strings = safe_emalloc(count, sizeof(zend_string *), 0);
+    uint32_t i = 0;
+    zval *sample;
+    ZEND_HASH_FOREACH_VAL(samples, sample) {
+        ZVAL_DEREF(sample);
+        if (Z_TYPE_P(sample) != IS_STRING) {
+            efree(sample_strings);
+            zend_argument_type_error(1, "must contain only strings, %s given", zend_zval_type_name(sample));
             RETURN_THROWS();
         }
-        
-        zend_string_release(obj->name);
-        obj->name = NULL;
-    }
-}
+        sample_strings[i++] = Z_STR_P(sample);
+    } ZEND_HASH_FOREACH_END();
 
-// Quick compress function
-ZEND_FUNCTION(Phillarmonic_FrankenZstd_compress)
-{
-    zend_string *data;
-    zend_long level = 3;
+    size_t result_len = 0;
+    uintptr_t pending = 0;
+    char *error = NULL;
 
-    ZEND_PARSE_PARAMETERS_START(1, 2)
-        Z_PARAM_STR(data)
-        Z_PARAM_OPTIONAL
-        Z_PARAM_LONG(level)
-    ZEND_PARSE_PARAMETERS_END();
+    go_train_dictionary(sample_strings, count, dict_id, max_size, &result_len, &pending, &error);
+    efree(sample_strings);
 
-    char *result, *error;
-    int result_len;
-    result = NULL;
-    error = NULL;
-    
-    go_quick_compress(data, level, &result, &result_len, &error);
-    
     if (error) {
-        zend_throw_exception_ex(compression_exception_ce, 0, "Compression failed: %s", error);
+        zend_throw_exception_ex(compression_exception_ce, 0, "Dictionary training failed: %s", error);
         free(error);
-        if (result) free(result);
         RETURN_THROWS();
     }
-    
-    if (result && result_len > 0) {
-        RETVAL_STRINGL(result, result_len);
-        free(result);
-    } else {
-        RETURN_EMPTY_STRING();
-    }
+
+    return_go_result(return_value, NULL, result_len, pending);
 }
 
-// Quick decompress function
-ZEND_FUNCTION(Phillarmonic_FrankenZstd_decompress)
+// Register a dictionary in the process-wide cache
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_registerDictionary)
 {
-    zend_string *compressed_data;
+    zend_string *dictionary;
 
     ZEND_PARSE_PARAMETERS_START(1, 1)
-        Z_PARAM_STR(compressed_data)
+        Z_PARAM_STR(dictionary)
     ZEND_PARSE_PARAMETERS_END();
 
-    char *result, *error;
-    int result_len;
-    result = NULL;
-    error = NULL;
-    
-    go_quick_decompress(compressed_data, &result, &result_len, &error);
-    
+    int64_t dict_id = 0;
+    char *error = go_register_dictionary(dictionary, &dict_id);
     if (error) {
-        zend_throw_exception_ex(compression_exception_ce, 0, "Decompression failed: %s", error);
+        zend_throw_exception_ex(compression_exception_ce, 0, "Failed to register dictionary: %s", error);
         free(error);
-        if (result) free(result);
         RETURN_THROWS();
     }
-    
-    if (result && result_len > 0) {
-        RETVAL_STRINGL(result, result_len);
-        free(result);
-    } else {
-        RETURN_EMPTY_STRING();
-    }
+
+    RETURN_LONG((zend_long)dict_id);
 }
 
 // Get zstd info function
@@ -253,19 +1625,76 @@ ZEND_FUNCTION(Phillarmonic_FrankenZstd_getInfo)
     ZEND_PARSE_PARAMETERS_NONE();
 
     char *version;
-    zend_long max_level, min_level, default_level;
+    zend_long max_level, min_level, default_level, bytes_copied;
     
-    go_get_zstd_info(&version, &max_level, &min_level, &default_level);
+    go_get_zstd_info(&version, &max_level, &min_level, &default_level, &bytes_copied);
     
     array_init(return_value);
     add_assoc_string(return_value, "version", version);
     add_assoc_long(return_value, "maxLevel", max_level);
     add_assoc_long(return_value, "minLevel", min_level);
     add_assoc_long(return_value, "defaultLevel", default_level);
+    add_assoc_long(return_value, "bytesCopied", bytes_copied);
     
     if (version) free(version);
 }
 
+// Get process-wide metrics function
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_getMetrics)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    franken_zstd_totals compress_totals[22], decompress_totals;
+    go_get_metrics(compress_totals, &decompress_totals);
+
+    // Only the levels in use are listed
+    zval levels, totals;
+    array_init(&levels);
+    for (int level = 1; level <= 22; level++) {
+        franken_zstd_totals *level_totals = &compress_totals[level - 1];
+        if (level_totals->operations || level_totals->errors) {
+            totals_to_array(&totals, level_totals);
+            add_index_zval(&levels, level, &totals);
+        }
+    }
+
+    array_init(return_value);
+    add_assoc_zval(return_value, "compress", &levels);
+    totals_to_array(&totals, &decompress_totals);
+    add_assoc_zval(return_value, "decompress", &totals);
+}
+
+// Get memory accounting function
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_getMemoryUsage)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    zend_long used, budget, evictions, decoder_max_memory;
+    go_get_memory_usage(&used, &budget, &evictions, &decoder_max_memory);
+
+    array_init(return_value);
+    add_assoc_long(return_value, "used", used);
+    add_assoc_long(return_value, "budget", budget);
+    add_assoc_long(return_value, "evictions", evictions);
+    add_assoc_long(return_value, "decoderMaxMemory", decoder_max_memory);
+}
+
+// Get compressed result cache counters function
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_getCacheStats)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    zend_long hits, misses, entries, size, capacity;
+    go_get_cache_stats(&hits, &misses, &entries, &size, &capacity);
+
+    array_init(return_value);
+    add_assoc_long(return_value, "hits", hits);
+    add_assoc_long(return_value, "misses", misses);
+    add_assoc_long(return_value, "entries", entries);
+    add_assoc_long(return_value, "size", size);
+    add_assoc_long(return_value, "capacity", capacity);
+}
+
 // Object handlers
 static zend_object_handlers compressor_object_handlers;
 
@@ -277,9 +1706,12 @@ static zend_object *compressor_create_object(zend_class_entry *ce)
     object_properties_init(&obj->std, ce);
     
     obj->std.handlers = &compressor_object_handlers;
-    obj->name = NULL;
+    obj->handle = 0;
     obj->level = 3;
     obj->window_size = 22;
+    obj->dict_id = 0;
+    obj->threads = 1;
+    obj->persistent = false;
     
     return &obj->std;
 }
@@ -288,10 +1720,10 @@ static void compressor_free_object(zend_object *object)
 {
     compressor_object *obj = compressor_from_obj(object);
     
-    if (obj->name) {
+    if (obj->handle && !obj->persistent) {
         // Clean up the Go compressor
-        go_compressor_close(obj->name);
-        zend_string_release(obj->name);
+        char *error = go_compressor_close(obj->handle);
+        if (error) free(error);
     }
     
     zend_object_std_dtor(object);
@@ -302,16 +1734,108 @@ static HashTable *compressor_get_properties(zend_object *object)
     compressor_object *obj = compressor_from_obj(object);
     HashTable *props = zend_std_get_properties(object);
     
-    zval level_zv, window_size_zv;
+    zval level_zv, window_size_zv, dict_id_zv, threads_zv, persistent_zv;
     ZVAL_LONG(&level_zv, obj->level);
     ZVAL_LONG(&window_size_zv, obj->window_size);
+    ZVAL_LONG(&dict_id_zv, obj->dict_id);
+    ZVAL_LONG(&threads_zv, obj->threads);
+    ZVAL_BOOL(&persistent_zv, obj->persistent);
     
     zend_hash_str_update(props, "level", sizeof("level") - 1, &level_zv);
     zend_hash_str_update(props, "windowSize", sizeof("windowSize") - 1, &window_size_zv);
+    zend_hash_str_update(props, "dictId", sizeof("dictId") - 1, &dict_id_zv);
+    zend_hash_str_update(props, "threads", sizeof("threads") - 1, &threads_zv);
+    zend_hash_str_update(props, "persistent", sizeof("persistent") - 1, &persistent_zv);
     
     return props;
 }
 
+static zend_object_handlers stream_compressor_object_handlers;
+static zend_object_handlers stream_decompressor_object_handlers;
+
+static zend_object *stream_create_object(zend_class_entry *ce, zend_object_handlers *handlers)
+{
+    stream_object *obj = zend_object_alloc(sizeof(stream_object), ce);
+    
+    zend_object_std_init(&obj->std, ce);
+    object_properties_init(&obj->std, ce);
+    
+    obj->std.handlers = handlers;
+    obj->handle = 0;
+    
+    return &obj->std;
+}
+
+static zend_object *stream_compressor_create_object(zend_class_entry *ce)
+{
+    return stream_create_object(ce, &stream_compressor_object_handlers);
+}
+
+static zend_object *stream_decompressor_create_object(zend_class_entry *ce)
+{
+    return stream_create_object(ce, &stream_decompressor_object_handlers);
+}
+
+static void stream_compressor_free_object(zend_object *object)
+{
+    stream_object *obj = stream_from_obj(object);
+    
+    if (obj->handle) {
+        char *error = go_stream_compressor_close(obj->handle);
+        if (error) free(error);
+    }
+    
+    zend_object_std_dtor(object);
+}
+
+static void stream_decompressor_free_object(zend_object *object)
+{
+    stream_object *obj = stream_from_obj(object);
+    
+    if (obj->handle) {
+        char *error = go_stream_decompressor_close(obj->handle);
+        if (error) free(error);
+    }
+    
+    zend_object_std_dtor(object);
+}
+
+static zend_object_handlers future_object_handlers;
+
+static zend_object *future_create_object(zend_class_entry *ce)
+{
+    future_object *obj = zend_object_alloc(sizeof(future_object), ce);
+
+    zend_object_std_init(&obj->std, ce);
+    object_properties_init(&obj->std, ce);
+
+    obj->std.handlers = &future_object_handlers;
+    obj->handle = 0;
+    obj->input = NULL;
+    obj->output = NULL;
+    obj->result = NULL;
+    obj->error = NULL;
+    obj->failure = NULL;
+
+    return &obj->std;
+}
+
+static void future_free_object(zend_object *object)
+{
+    future_object *obj = future_from_obj(object);
+
+    // The goroutine may still use the input and output
+    if (obj->handle) {
+        go_future_discard(obj->handle);
+    }
+    if (obj->output) zend_string_efree(obj->output);
+    if (obj->input) zend_string_release(obj->input);
+    if (obj->result) zend_string_release(obj->result);
+    if (obj->error) zend_string_release(obj->error);
+
+    zend_object_std_dtor(object);
+}
+
 // Module initialization
 PHP_MINIT_FUNCTION(zstd)
 {
@@ -342,13 +1866,59 @@ PHP_MINIT_FUNCTION(zstd)
     zend_declare_class_constant_long(compressor_ce, "WINDOW_SIZE_DEFAULT", sizeof("WINDOW_SIZE_DEFAULT") - 1, 22);
     zend_declare_class_constant_long(compressor_ce, "WINDOW_SIZE_MAX", sizeof("WINDOW_SIZE_MAX") - 1, 31);
 
+    // Register StreamCompressor class
+    INIT_NS_CLASS_ENTRY(ce, "Phillarmonic\\FrankenZstd", "StreamCompressor", class_Phillarmonic_FrankenZstd_StreamCompressor_methods);
+    stream_compressor_ce = zend_register_internal_class(&ce);
+    stream_compressor_ce->create_object = stream_compressor_create_object;
+    
+    memcpy(&stream_compressor_object_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+    stream_compressor_object_handlers.free_obj = stream_compressor_free_object;
+    stream_compressor_object_handlers.offset = XtOffsetOf(stream_object, std);
+
+    // Register StreamDecompressor class
+    INIT_NS_CLASS_ENTRY(ce, "Phillarmonic\\FrankenZstd", "StreamDecompressor", class_Phillarmonic_FrankenZstd_StreamDecompressor_methods);
+    stream_decompressor_ce = zend_register_internal_class(&ce);
+    stream_decompressor_ce->create_object = stream_decompressor_create_object;
+    
+    memcpy(&stream_decompressor_object_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+    stream_decompressor_object_handlers.free_obj = stream_decompressor_free_object;
+    stream_decompressor_object_handlers.offset = XtOffsetOf(stream_object, std);
+
+    // Register Future class
+    INIT_NS_CLASS_ENTRY(ce, "Phillarmonic\\FrankenZstd", "Future", class_Phillarmonic_FrankenZstd_Future_methods);
+    future_ce = zend_register_internal_class(&ce);
+    future_ce->create_object = future_create_object;
+
+    memcpy(&future_object_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+    future_object_handlers.free_obj = future_free_object;
+    future_object_handlers.clone_obj = NULL;
+    future_object_handlers.offset = XtOffsetOf(future_object, std);
+
+    php_output_handler_conflict_register(ZEND_STRL(OUTPUT_HANDLER_NAME), output_conflict_check);
+
+    // Register the compress.zstd:// wrapper and zstd.* filters
+    return PHP_MINIT(zstd_stream)(INIT_FUNC_ARGS_PASSTHRU);
+}
+
+// Request shutdown: drops the stream of an output buffer left open
+PHP_RSHUTDOWN_FUNCTION(zstd)
+{
+    output_stop();
+    ZSTD_G(ob_failed) = false;
     return SUCCESS;
 }
 
+static PHP_GINIT_FUNCTION(zstd)
+{
+    zstd_globals->ob_handle = 0;
+    zstd_globals->ob_sent = false;
+    zstd_globals->ob_failed = false;
+}
+
 // Module shutdown
 PHP_MSHUTDOWN_FUNCTION(zstd)
 {
-    return SUCCESS;
+    return PHP_MSHUTDOWN(zstd_stream)(SHUTDOWN_FUNC_ARGS_PASSTHRU);
 }
 
 // Module info
@@ -368,10 +1938,14 @@ zend_module_entry zstd_module_entry = {
     PHP_MINIT(zstd),
     PHP_MSHUTDOWN(zstd),
     NULL,
-    NULL,
+    PHP_RSHUTDOWN(zstd),
     PHP_MINFO(zstd),
     "1.0.3",
-    STANDARD_MODULE_PROPERTIES
+    PHP_MODULE_GLOBALS(zstd),
+    PHP_GINIT(zstd),
+    NULL,
+    NULL,
+    STANDARD_MODULE_PROPERTIES_EX
 };
 
 void register_extension()
@@ -5,6 +5,46 @@
 
 extern zend_module_entry zstd_module_entry;
 
+// Worst-case size of a zstd frame holding n bytes: 3 bytes of block header
+// per 1KB block (the smallest window) plus frame header, dictionary ID and
+// checksum. Output buffers are allocated from this before calling into Go.
+#define FRANKEN_ZSTD_COMPRESS_BOUND(n) ((n) + ((n) >> 8) + 64)
+
+// Worst case of a seekable payload: every frame adds its own header,
+// checksum and block slack plus an 8-byte seek table entry, and the seek
+// table adds its skippable frame header and footer.
+#define FRANKEN_ZSTD_SEEKABLE_BOUND(n, frame_size) \
+    (FRANKEN_ZSTD_COMPRESS_BOUND(n) + ((n) / (frame_size) + 1) * 96 + 17)
+
+// Input size classes an adaptive compressor picks a level for, reported by
+// getStats()
+#define FRANKEN_ZSTD_ADAPTIVE_CLASSES 4
+
+// Cumulative totals of one kind of operation, filled by Go for getStats()
+// and getMetrics()
+typedef struct {
+    int64_t operations;
+    int64_t errors;
+    int64_t bytes_in;
+    int64_t bytes_out;
+    int64_t nanoseconds;
+} franken_zstd_totals;
+
+// Per-request state: the stream of the output handler, 0 when the response
+// is not being compressed, whether it returned compressed bytes yet, and
+// whether it failed after the response was announced as zstd
+ZEND_BEGIN_MODULE_GLOBALS(zstd)
+    uint64_t ob_handle;
+    bool ob_sent;
+    bool ob_failed;
+ZEND_END_MODULE_GLOBALS(zstd)
+
+#define ZSTD_G(v) ZEND_MODULE_GLOBALS_ACCESSOR(zstd, v)
+
+// compress.zstd:// wrapper and zstd.* stream filters (zstd_stream.c)
+PHP_MINIT_FUNCTION(zstd_stream);
+PHP_MSHUTDOWN_FUNCTION(zstd_stream);
+
 void register_extension();
 
 #endif
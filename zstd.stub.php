@@ -22,12 +22,44 @@ namespace Phillarmonic\FrankenZstd {
          *
          * @param int $level Compression level (1-22, default: 3)
          * @param int $windowSize Window size for compression (10-31, default: 22)
+         * @param int $dictId ID of a registered dictionary to compress with (0 for none)
+         * @param int $threads Number of frames large inputs are split into and compressed in parallel (1-256, default: 1)
          */
-        public static function create(int $level = Compressor::LEVEL_DEFAULT, int $windowSize = Compressor::WINDOW_SIZE_DEFAULT): \Phillarmonic\FrankenZstd\Compressor {
+        public static function create(int $level = Compressor::LEVEL_DEFAULT, int $windowSize = Compressor::WINDOW_SIZE_DEFAULT, int $dictId = 0, int $threads = 1): \Phillarmonic\FrankenZstd\Compressor {
         }
         
         /**
-         * The compression level of this instance.
+         * Returns the process-wide compressor registered under a name, creating it
+         * with the given settings on first use. It survives the request and is
+         * shared by every thread; close() only detaches this instance.
+         *
+         * @param string $name Name of the compressor
+         * @param int $level Compression level (1-22, default: 3)
+         * @param int $windowSize Window size for compression (10-31, default: 22)
+         * @param int $dictId ID of a registered dictionary to compress with (0 for none)
+         * @param int $threads Number of frames large inputs are split into and compressed in parallel (1-256, default: 1)
+         * @throws \Phillarmonic\FrankenZstd\CompressionException If the name exists with other settings
+         */
+        public static function persistent(string $name, int $level = Compressor::LEVEL_DEFAULT, int $windowSize = Compressor::WINDOW_SIZE_DEFAULT, int $dictId = 0, int $threads = 1): \Phillarmonic\FrankenZstd\Compressor {
+        }
+        
+        /**
+         * Creates a compressor that picks its level per input size class: the
+         * strongest of LEVEL_FASTEST, LEVEL_DEFAULT, LEVEL_BETTER and LEVEL_ULTRA
+         * whose measured throughput meets the target. Levels back off when
+         * encodes slow down, e.g. under CPU pressure. A latency budget of N
+         * milliseconds per MB is a target of 1000 / N.
+         *
+         * @param float $targetThroughput Minimum compression throughput in MB/s
+         * @param int $windowSize Window size for compression (10-31, default: 22)
+         * @param int $dictId ID of a registered dictionary to compress with (0 for none)
+         * @param int $threads Number of frames large inputs are split into and compressed in parallel (1-256, default: 1)
+         */
+        public static function adaptive(float $targetThroughput, int $windowSize = Compressor::WINDOW_SIZE_DEFAULT, int $dictId = 0, int $threads = 1): \Phillarmonic\FrankenZstd\Compressor {
+        }
+        
+        /**
+         * The compression level of this instance (0 for an adaptive compressor).
          */
         public readonly int $level;
         
@@ -36,6 +68,21 @@ namespace Phillarmonic\FrankenZstd {
          */
         public readonly int $windowSize;
         
+        /**
+         * The dictionary ID of this instance (0 for none).
+         */
+        public readonly int $dictId;
+        
+        /**
+         * The number of threads large inputs are compressed with.
+         */
+        public readonly int $threads;
+        
+        /**
+         * Whether this instance is a process-wide persistent compressor.
+         */
+        public readonly bool $persistent;
+        
         /**
          * Compresses data using zstd algorithm.
          *
@@ -48,22 +95,48 @@ namespace Phillarmonic\FrankenZstd {
         
         /**
          * Decompresses zstd-compressed data.
+         * Frames compressed with a registered dictionary are decompressed with it.
          *
          * @param string $compressedData Compressed data to decompress
+         * @param int $maxOutputSize Maximum decompressed size in bytes (0 for no limit)
          * @return string Decompressed data
-         * @throws \Phillarmonic\FrankenZstd\CompressionException
+         * @throws \Phillarmonic\FrankenZstd\CompressionException If the data is invalid or decompresses to more than $maxOutputSize bytes
+         */
+        public function decompress(string $compressedData, int $maxOutputSize = 0): string {
+        }
+        
+        /**
+         * Compresses a batch of strings in parallel with this compressor's settings.
+         * The stats afterwards describe the whole batch.
+         *
+         * @param array<array-key, string> $items Strings to compress
+         * @return array<array-key, string|\Phillarmonic\FrankenZstd\CompressionException> Compressed strings under the keys of $items; an item that failed holds its exception
+         */
+        public function compressMany(array $items): array {
+        }
+        
+        /**
+         * Decompresses a batch of frames in parallel.
+         *
+         * @param array<array-key, string> $items Compressed strings
+         * @param int $maxOutputSize Maximum decompressed size of each item in bytes (0 for no limit)
+         * @return array<array-key, string|\Phillarmonic\FrankenZstd\CompressionException> Decompressed strings under the keys of $items; an item that failed holds its exception
          */
-        public function decompress(string $compressedData): string {
+        public function decompressMany(array $items, int $maxOutputSize = 0): array {
         }
         
         /**
-         * Gets compression statistics for the last operation.
+         * Gets compression statistics for the last operation, plus cumulative
+         * totals of every compression and decompression of this instance.
          *
          * @return array{
          *     originalSize: int,
          *     compressedSize: int,
          *     compressionRatio: float,
-         *     compressionTime: float
+         *     compressionTime: float,
+         *     compress: array{operations: int, errors: int, bytesIn: int, bytesOut: int, time: float},
+         *     decompress: array{operations: int, errors: int, bytesIn: int, bytesOut: int, time: float},
+         *     adaptive?: array{target: float, classes: list<array{minSize: int, level: int, throughput: float}>}
          * }
          */
         public function getStats(): array {
@@ -82,25 +155,318 @@ namespace Phillarmonic\FrankenZstd {
         }
     }
     
+    final class StreamCompressor
+    {
+        /**
+         * Creates a compressor that produces a single zstd frame incrementally.
+         * Memory is bounded by the window size, not by the payload size.
+         *
+         * @param int $level Compression level (1-22, default: 3)
+         * @param int $windowSize Window size for compression (10-31, default: 22)
+         * @param int $dictId ID of a registered dictionary to compress with (0 for none)
+         * @throws \Phillarmonic\FrankenZstd\CompressionException
+         */
+        public static function create(int $level = Compressor::LEVEL_DEFAULT, int $windowSize = Compressor::WINDOW_SIZE_DEFAULT, int $dictId = 0): \Phillarmonic\FrankenZstd\StreamCompressor {
+        }
+        
+        /**
+         * Compresses a chunk of data.
+         *
+         * @param string $data Chunk to compress
+         * @return string Compressed bytes produced so far (may be empty)
+         * @throws \Phillarmonic\FrankenZstd\CompressionException
+         */
+        public function write(string $data): string {
+        }
+        
+        /**
+         * Ends the current block so everything written so far can be decompressed.
+         *
+         * @return string Compressed bytes of the flushed block
+         * @throws \Phillarmonic\FrankenZstd\CompressionException
+         */
+        public function flush(): string {
+        }
+        
+        /**
+         * Ends the frame. No data can be written afterwards.
+         *
+         * @return string Remaining compressed bytes
+         * @throws \Phillarmonic\FrankenZstd\CompressionException
+         */
+        public function finish(): string {
+        }
+        
+        /**
+         * Releases the stream without finishing the frame.
+         */
+        public function close(): void {
+        }
+    }
+    
+    final class StreamDecompressor
+    {
+        /**
+         * Creates a decompressor fed with compressed chunks. Memory is bounded
+         * by the window size of the stream, not by the payload size.
+         * Every registered dictionary is available to it.
+         *
+         * @param int $maxWindowSize Largest accepted window as a power of two (10-31, default: 27)
+         * @throws \Phillarmonic\FrankenZstd\CompressionException
+         */
+        public static function create(int $maxWindowSize = 27): \Phillarmonic\FrankenZstd\StreamDecompressor {
+        }
+        
+        /**
+         * Decompresses a chunk of compressed data. With $maxLength set, the
+         * output beyond it stays in the decompressor for read().
+         *
+         * @param string $data Chunk of compressed data
+         * @param int $maxLength Maximum length of the returned output in bytes (0 for no limit)
+         * @return string Output decoded so far (may be empty)
+         * @throws \Phillarmonic\FrankenZstd\CompressionException
+         */
+        public function write(string $data, int $maxLength = 0): string {
+        }
+        
+        /**
+         * Returns output left over by a write() or finish() with a maximum
+         * length, decoding the input already written as needed.
+         *
+         * @param int $maxLength Maximum length of the returned output in bytes (0 for no limit)
+         * @return string Decoded output; empty once the decompressor needs more input or the stream ended
+         * @throws \Phillarmonic\FrankenZstd\CompressionException
+         */
+        public function read(int $maxLength = 0): string {
+        }
+        
+        /**
+         * Signals the end of the input.
+         *
+         * @param int $maxLength Maximum length of the returned output in bytes (0 for no limit)
+         * @return string Remaining decoded output, or its first $maxLength bytes
+         * @throws \Phillarmonic\FrankenZstd\CompressionException If the input ended inside a frame
+         */
+        public function finish(int $maxLength = 0): string {
+        }
+        
+        /**
+         * Releases the stream without checking that the input was complete.
+         */
+        public function close(): void {
+        }
+    }
+    
+    final class Future
+    {
+        /**
+         * Blocks until the operation completes. The result is kept, so it
+         * can be read again.
+         *
+         * @return string Compressed or decompressed data
+         * @throws \Phillarmonic\FrankenZstd\CompressionException If the operation failed
+         */
+        public function wait(): string {
+        }
+        
+        /**
+         * Checks without blocking whether the operation completed.
+         */
+        public function isReady(): bool {
+        }
+        
+        /**
+         * Blocks until every future completes.
+         *
+         * @param array<array-key, \Phillarmonic\FrankenZstd\Future> $futures Futures to wait for
+         * @return array<array-key, string|\Phillarmonic\FrankenZstd\CompressionException> Results under the keys of $futures; a future that failed holds its exception
+         */
+        public static function waitAll(array $futures): array {
+        }
+    }
+    
     /**
      * Quick compress function for simple use cases.
      *
      * @param string $data Data to compress
      * @param int $level Compression level (1-22, default: 3)
+     * @param int $dictId ID of a registered dictionary to compress with (0 for none)
      * @return string Compressed data
      * @throws \Phillarmonic\FrankenZstd\CompressionException
      */
-    function compress(string $data, int $level = Compressor::LEVEL_DEFAULT): string {
+    function compress(string $data, int $level = Compressor::LEVEL_DEFAULT, int $dictId = 0): string {
     }
     
     /**
      * Quick decompress function for simple use cases.
+     * The dictionary is picked from the frame header when the frame uses one.
      *
      * @param string $compressedData Compressed data
+     * @param int $maxOutputSize Maximum decompressed size in bytes (0 for no limit)
      * @return string Decompressed data
+     * @throws \Phillarmonic\FrankenZstd\CompressionException If the data is invalid or decompresses to more than $maxOutputSize bytes
+     */
+    function decompress(string $compressedData, int $maxOutputSize = 0): string {
+    }
+    
+    /**
+     * Compresses a batch of strings in parallel, in a single call.
+     *
+     * @param array<array-key, string> $items Strings to compress
+     * @param int $level Compression level (1-22, default: 3)
+     * @param int $dictId ID of a registered dictionary to compress with (0 for none)
+     * @return array<array-key, string|\Phillarmonic\FrankenZstd\CompressionException> Compressed strings under the keys of $items; an item that failed holds its exception
+     * @throws \Phillarmonic\FrankenZstd\CompressionException If the level or dictionary is invalid
+     */
+    function compressMany(array $items, int $level = Compressor::LEVEL_DEFAULT, int $dictId = 0): array {
+    }
+    
+    /**
+     * Decompresses a batch of frames in parallel, in a single call.
+     *
+     * @param array<array-key, string> $items Compressed strings
+     * @param int $maxOutputSize Maximum decompressed size of each item in bytes (0 for no limit)
+     * @return array<array-key, string|\Phillarmonic\FrankenZstd\CompressionException> Decompressed strings under the keys of $items; an item that failed holds its exception
+     */
+    function decompressMany(array $items, int $maxOutputSize = 0): array {
+    }
+    
+    /**
+     * Compresses a new version of a document against a reference version,
+     * as zstd --patch-from: the parts shared with the reference are encoded
+     * as matches into it, so the patch holds little more than the changes.
+     *
+     * @param string $reference Previous version, needed again to decompress
+     * @param string $data New version
+     * @param int $level Compression level (1-22, default: 3)
+     * @return string Patch in zstd format
+     * @throws \Phillarmonic\FrankenZstd\CompressionException
+     */
+    function compressDelta(string $reference, string $data, int $level = Compressor::LEVEL_DEFAULT): string {
+    }
+    
+    /**
+     * Decompresses a patch made by compressDelta() against the same reference.
+     *
+     * @param string $reference Version the patch was compressed against
+     * @param string $patch Patch in zstd format
+     * @return string The new version
+     * @throws \Phillarmonic\FrankenZstd\CompressionException If the patch is invalid or the reference differs
+     */
+    function decompressDelta(string $reference, string $patch): string {
+    }
+    
+    /**
+     * Compresses a file into another without loading it into PHP memory.
+     * Large inputs are read and compressed in 4MB segments, each into its
+     * own frame, so memory stays bounded whatever the size of the file.
+     *
+     * @param string $source Path of the file to compress
+     * @param string $destination Path of the compressed file, replaced if it exists
+     * @param int $level Compression level (1-22, default: 3)
+     * @param int $dictId ID of a registered dictionary to compress with (0 for none)
+     * @param int $threads Number of segments compressed in parallel (1-256, default: 1)
+     * @return array{bytesIn: int, bytesOut: int, compressionRatio: float, time: float}
+     * @throws \Phillarmonic\FrankenZstd\CompressionException
+     */
+    function compressFile(string $source, string $destination, int $level = Compressor::LEVEL_DEFAULT, int $dictId = 0, int $threads = 1): array {
+    }
+    
+    /**
+     * Decompresses a file into another without loading it into PHP memory.
+     *
+     * @param string $source Path of the zstd file
+     * @param string $destination Path of the decompressed file, replaced if it exists
+     * @param int $maxOutputSize Maximum decompressed size in bytes (0 for no limit)
+     * @return array{bytesIn: int, bytesOut: int, compressionRatio: float, time: float}
+     * @throws \Phillarmonic\FrankenZstd\CompressionException
+     */
+    function decompressFile(string $source, string $destination, int $maxOutputSize = 0): array {
+    }
+    
+    /**
+     * Starts compressing data in the background and returns at once.
+     *
+     * @param string $data Data to compress
+     * @param int $level Compression level (1-22, default: 3)
+     * @param int $dictId ID of a registered dictionary to compress with (0 for none)
+     * @return \Phillarmonic\FrankenZstd\Future Future of the compressed data
+     * @throws \Phillarmonic\FrankenZstd\CompressionException If the level or dictionary is invalid
+     */
+    function compressAsync(string $data, int $level = Compressor::LEVEL_DEFAULT, int $dictId = 0): Future {
+    }
+    
+    /**
+     * Starts decompressing data in the background and returns at once.
+     *
+     * @param string $compressedData Compressed data
+     * @param int $maxOutputSize Maximum decompressed size in bytes (0 for no limit)
+     * @return \Phillarmonic\FrankenZstd\Future Future of the decompressed data
+     */
+    function decompressAsync(string $compressedData, int $maxOutputSize = 0): Future {
+    }
+    
+    /**
+     * Output buffer handler compressing the response as it is produced:
+     * ob_start('Phillarmonic\\FrankenZstd\\ob_handler'). Each ob_flush() ends
+     * a zstd block, so the client can decode everything sent so far. The
+     * response is left uncompressed when the request does not accept zstd
+     * or headers were already sent.
+     *
+     * @param string $buffer Contents of the output buffer
+     * @param int $phase Bitmask of PHP_OUTPUT_HANDLER_* flags
+     * @return string|false Compressed output, or false to pass the buffer through
+     */
+    function ob_handler(string $buffer, int $phase): string|false {
+    }
+    
+    /**
+     * Compresses data in the zstd seekable format: independent frames followed
+     * by a seek table, so ranges can be decompressed without the whole payload.
+     * The result is also readable by decompress() and any zstd decoder.
+     *
+     * @param string $data Data to compress
+     * @param int $level Compression level (1-22, default: 3)
+     * @param int $frameSize Decompressed size of each frame (1024-1073741824, default: 1048576)
+     * @return string Compressed data with its seek table
+     * @throws \Phillarmonic\FrankenZstd\CompressionException
+     */
+    function compressSeekable(string $data, int $level = Compressor::LEVEL_DEFAULT, int $frameSize = 1048576): string {
+    }
+    
+    /**
+     * Decompresses a range of the content of a seekable payload, decoding
+     * only the frames covering it.
+     *
+     * @param string $data Payload in the zstd seekable format
+     * @param int $offset Offset of the range in the decompressed content
+     * @param int $length Length of the range, clamped to the end of the content
+     * @return string The decompressed range
+     * @throws \Phillarmonic\FrankenZstd\CompressionException
+     */
+    function decompressRange(string $data, int $offset, int $length): string {
+    }
+    
+    /**
+     * Trains a zstd dictionary from sample strings.
+     *
+     * @param string[] $samples Representative samples of the data to compress
+     * @param int $dictId Dictionary ID (0 to derive one from the samples)
+     * @param int $maxSize Maximum dictionary size in bytes (256-1048576, default: 112640)
+     * @return string Dictionary in zstd format
      * @throws \Phillarmonic\FrankenZstd\CompressionException
      */
-    function decompress(string $compressedData): string {
+    function trainDictionary(array $samples, int $dictId = 0, int $maxSize = 112640): string {
+    }
+    
+    /**
+     * Registers a dictionary in the process-wide cache shared by all threads.
+     *
+     * @param string $dictionary Dictionary in zstd format
+     * @return int The dictionary ID
+     * @throws \Phillarmonic\FrankenZstd\CompressionException
+     */
+    function registerDictionary(string $dictionary): int {
     }
     
     /**
@@ -110,9 +476,42 @@ namespace Phillarmonic\FrankenZstd {
      *     version: string,
      *     maxLevel: int,
      *     minLevel: int,
-     *     defaultLevel: int
+     *     defaultLevel: int,
+     *     bytesCopied: int
      * }
      */
     function getInfo(): array {
     }
+    
+    /**
+     * Gets cumulative metrics of the whole process, shared by all threads:
+     * compression per level (levels in use only) and decompression.
+     *
+     * @return array{
+     *     compress: array<int, array{operations: int, errors: int, bytesIn: int, bytesOut: int, time: float}>,
+     *     decompress: array{operations: int, errors: int, bytesIn: int, bytesOut: int, time: float}
+     * }
+     */
+    function getMetrics(): array {
+    }
+    
+    /**
+     * Gets the memory accounting of compressor encoders and decoders: the
+     * estimated bytes in use, the configured budget (0 for none), the number
+     * of evictions and the decoder memory cap (0 for the library default).
+     *
+     * @return array{used: int, budget: int, evictions: int, decoderMaxMemory: int}
+     */
+    function getMemoryUsage(): array {
+    }
+    
+    /**
+     * Gets the counters of the process-wide cache of compressed results:
+     * lookups answered from it and not, and the entries and bytes it holds
+     * against its capacity (0 when the cache is disabled).
+     *
+     * @return array{hits: int, misses: int, entries: int, size: int, capacity: int}
+     */
+    function getCacheStats(): array {
+    }
 }
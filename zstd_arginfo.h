@@ -1,21 +1,120 @@
 /* This is a generated file, edit the .stub.php file instead.
- * Stub hash: 478924729ffc6e4284d5980dc1e639151a00ee96 */
+ * Stub hash: 6524ce0d50bdf992a38f4500c8f3e138bf7904ba */
 
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_Phillarmonic_FrankenZstd_compress, 0, 1, IS_STRING, 0)
 	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
 	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, level, IS_LONG, 0, "Phillarmonic\\FrankenZstd\\Compressor::LEVEL_DEFAULT")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, dictId, IS_LONG, 0, "0")
 ZEND_END_ARG_INFO()
 
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_Phillarmonic_FrankenZstd_decompress, 0, 1, IS_STRING, 0)
 	ZEND_ARG_TYPE_INFO(0, compressedData, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxOutputSize, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_Phillarmonic_FrankenZstd_compressMany, 0, 1, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, items, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, level, IS_LONG, 0, "Phillarmonic\\FrankenZstd\\Compressor::LEVEL_DEFAULT")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, dictId, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_Phillarmonic_FrankenZstd_decompressMany, 0, 1, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, items, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxOutputSize, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_Phillarmonic_FrankenZstd_compressDelta, 0, 2, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, reference, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, level, IS_LONG, 0, "Phillarmonic\\FrankenZstd\\Compressor::LEVEL_DEFAULT")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_Phillarmonic_FrankenZstd_decompressDelta, 0, 2, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, reference, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, patch, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_Phillarmonic_FrankenZstd_compressFile, 0, 2, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, source, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, destination, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, level, IS_LONG, 0, "Phillarmonic\\FrankenZstd\\Compressor::LEVEL_DEFAULT")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, dictId, IS_LONG, 0, "0")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, threads, IS_LONG, 0, "1")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_Phillarmonic_FrankenZstd_decompressFile, 0, 2, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, source, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, destination, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxOutputSize, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_Phillarmonic_FrankenZstd_compressAsync, 0, 1, Phillarmonic\\FrankenZstd\\Future, 0)
+	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, level, IS_LONG, 0, "Phillarmonic\\FrankenZstd\\Compressor::LEVEL_DEFAULT")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, dictId, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_Phillarmonic_FrankenZstd_decompressAsync, 0, 1, Phillarmonic\\FrankenZstd\\Future, 0)
+	ZEND_ARG_TYPE_INFO(0, compressedData, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxOutputSize, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_MASK_EX(arginfo_Phillarmonic_FrankenZstd_ob_handler, 0, 2, MAY_BE_STRING|MAY_BE_FALSE)
+	ZEND_ARG_TYPE_INFO(0, buffer, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, phase, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_Phillarmonic_FrankenZstd_compressSeekable, 0, 1, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, level, IS_LONG, 0, "Phillarmonic\\FrankenZstd\\Compressor::LEVEL_DEFAULT")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, frameSize, IS_LONG, 0, "1048576")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_Phillarmonic_FrankenZstd_decompressRange, 0, 3, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, offset, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(0, length, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_Phillarmonic_FrankenZstd_trainDictionary, 0, 1, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, samples, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, dictId, IS_LONG, 0, "0")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxSize, IS_LONG, 0, "112640")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_Phillarmonic_FrankenZstd_registerDictionary, 0, 1, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(0, dictionary, IS_STRING, 0)
 ZEND_END_ARG_INFO()
 
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_Phillarmonic_FrankenZstd_getInfo, 0, 0, IS_ARRAY, 0)
 ZEND_END_ARG_INFO()
 
+#define arginfo_Phillarmonic_FrankenZstd_getMetrics arginfo_Phillarmonic_FrankenZstd_getInfo
+
+#define arginfo_Phillarmonic_FrankenZstd_getMemoryUsage arginfo_Phillarmonic_FrankenZstd_getInfo
+
+#define arginfo_Phillarmonic_FrankenZstd_getCacheStats arginfo_Phillarmonic_FrankenZstd_getInfo
+
 ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_class_Phillarmonic_FrankenZstd_Compressor_create, 0, 0, Phillarmonic\\FrankenZstd\\Compressor, 0)
 	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, level, IS_LONG, 0, "Phillarmonic\\FrankenZstd\\Compressor::LEVEL_DEFAULT")
 	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, windowSize, IS_LONG, 0, "Phillarmonic\\FrankenZstd\\Compressor::WINDOW_SIZE_DEFAULT")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, dictId, IS_LONG, 0, "0")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, threads, IS_LONG, 0, "1")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_class_Phillarmonic_FrankenZstd_Compressor_persistent, 0, 1, Phillarmonic\\FrankenZstd\\Compressor, 0)
+	ZEND_ARG_TYPE_INFO(0, name, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, level, IS_LONG, 0, "Phillarmonic\\FrankenZstd\\Compressor::LEVEL_DEFAULT")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, windowSize, IS_LONG, 0, "Phillarmonic\\FrankenZstd\\Compressor::WINDOW_SIZE_DEFAULT")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, dictId, IS_LONG, 0, "0")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, threads, IS_LONG, 0, "1")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_class_Phillarmonic_FrankenZstd_Compressor_adaptive, 0, 1, Phillarmonic\\FrankenZstd\\Compressor, 0)
+	ZEND_ARG_TYPE_INFO(0, targetThroughput, IS_DOUBLE, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, windowSize, IS_LONG, 0, "Phillarmonic\\FrankenZstd\\Compressor::WINDOW_SIZE_DEFAULT")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, dictId, IS_LONG, 0, "0")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, threads, IS_LONG, 0, "1")
 ZEND_END_ARG_INFO()
 
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Phillarmonic_FrankenZstd_Compressor_compress, 0, 1, IS_STRING, 0)
@@ -24,6 +123,12 @@ ZEND_END_ARG_INFO()
 
 #define arginfo_class_Phillarmonic_FrankenZstd_Compressor_decompress arginfo_Phillarmonic_FrankenZstd_decompress
 
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Phillarmonic_FrankenZstd_Compressor_compressMany, 0, 1, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, items, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Phillarmonic_FrankenZstd_Compressor_decompressMany arginfo_Phillarmonic_FrankenZstd_decompressMany
+
 #define arginfo_class_Phillarmonic_FrankenZstd_Compressor_getStats arginfo_Phillarmonic_FrankenZstd_getInfo
 
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Phillarmonic_FrankenZstd_Compressor_close, 0, 0, IS_VOID, 0)
@@ -35,27 +140,121 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Phillarmonic_FrankenZstd_CompressionExcepti
 	ZEND_ARG_OBJ_INFO_WITH_DEFAULT_VALUE(0, previous, Throwable, 1, "null")
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_class_Phillarmonic_FrankenZstd_StreamCompressor_create, 0, 0, Phillarmonic\\FrankenZstd\\StreamCompressor, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, level, IS_LONG, 0, "Phillarmonic\\FrankenZstd\\Compressor::LEVEL_DEFAULT")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, windowSize, IS_LONG, 0, "Phillarmonic\\FrankenZstd\\Compressor::WINDOW_SIZE_DEFAULT")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, dictId, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Phillarmonic_FrankenZstd_StreamCompressor_write arginfo_class_Phillarmonic_FrankenZstd_Compressor_compress
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Phillarmonic_FrankenZstd_StreamCompressor_flush, 0, 0, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Phillarmonic_FrankenZstd_StreamCompressor_finish arginfo_class_Phillarmonic_FrankenZstd_StreamCompressor_flush
+
+#define arginfo_class_Phillarmonic_FrankenZstd_StreamCompressor_close arginfo_class_Phillarmonic_FrankenZstd_Compressor_close
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_class_Phillarmonic_FrankenZstd_StreamDecompressor_create, 0, 0, Phillarmonic\\FrankenZstd\\StreamDecompressor, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxWindowSize, IS_LONG, 0, "27")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Phillarmonic_FrankenZstd_StreamDecompressor_write, 0, 1, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxLength, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Phillarmonic_FrankenZstd_StreamDecompressor_read, 0, 0, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, maxLength, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Phillarmonic_FrankenZstd_StreamDecompressor_finish arginfo_class_Phillarmonic_FrankenZstd_StreamDecompressor_read
+
+#define arginfo_class_Phillarmonic_FrankenZstd_StreamDecompressor_close arginfo_class_Phillarmonic_FrankenZstd_Compressor_close
+
+#define arginfo_class_Phillarmonic_FrankenZstd_Future_wait arginfo_class_Phillarmonic_FrankenZstd_StreamCompressor_flush
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Phillarmonic_FrankenZstd_Future_isReady, 0, 0, _IS_BOOL, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Phillarmonic_FrankenZstd_Future_waitAll, 0, 1, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, futures, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
 ZEND_FUNCTION(Phillarmonic_FrankenZstd_compress);
 ZEND_FUNCTION(Phillarmonic_FrankenZstd_decompress);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_compressMany);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_decompressMany);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_compressDelta);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_decompressDelta);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_compressFile);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_decompressFile);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_compressAsync);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_decompressAsync);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_ob_handler);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_compressSeekable);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_decompressRange);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_trainDictionary);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_registerDictionary);
 ZEND_FUNCTION(Phillarmonic_FrankenZstd_getInfo);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_getMetrics);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_getMemoryUsage);
+ZEND_FUNCTION(Phillarmonic_FrankenZstd_getCacheStats);
 ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, create);
+ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, persistent);
+ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, adaptive);
 ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, compress);
 ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, decompress);
+ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, compressMany);
+ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, decompressMany);
 ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, getStats);
 ZEND_METHOD(Phillarmonic_FrankenZstd_Compressor, close);
 ZEND_METHOD(Phillarmonic_FrankenZstd_CompressionException, __construct);
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamCompressor, create);
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamCompressor, write);
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamCompressor, flush);
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamCompressor, finish);
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamCompressor, close);
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamDecompressor, create);
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamDecompressor, write);
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamDecompressor, read);
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamDecompressor, finish);
+ZEND_METHOD(Phillarmonic_FrankenZstd_StreamDecompressor, close);
+ZEND_METHOD(Phillarmonic_FrankenZstd_Future, wait);
+ZEND_METHOD(Phillarmonic_FrankenZstd_Future, isReady);
+ZEND_METHOD(Phillarmonic_FrankenZstd_Future, waitAll);
 
 static const zend_function_entry ext_functions[] = {
 	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "compress"), zif_Phillarmonic_FrankenZstd_compress, arginfo_Phillarmonic_FrankenZstd_compress, 0, NULL, NULL)
 	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "decompress"), zif_Phillarmonic_FrankenZstd_decompress, arginfo_Phillarmonic_FrankenZstd_decompress, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "compressMany"), zif_Phillarmonic_FrankenZstd_compressMany, arginfo_Phillarmonic_FrankenZstd_compressMany, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "decompressMany"), zif_Phillarmonic_FrankenZstd_decompressMany, arginfo_Phillarmonic_FrankenZstd_decompressMany, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "compressDelta"), zif_Phillarmonic_FrankenZstd_compressDelta, arginfo_Phillarmonic_FrankenZstd_compressDelta, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "decompressDelta"), zif_Phillarmonic_FrankenZstd_decompressDelta, arginfo_Phillarmonic_FrankenZstd_decompressDelta, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "compressFile"), zif_Phillarmonic_FrankenZstd_compressFile, arginfo_Phillarmonic_FrankenZstd_compressFile, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "decompressFile"), zif_Phillarmonic_FrankenZstd_decompressFile, arginfo_Phillarmonic_FrankenZstd_decompressFile, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "compressAsync"), zif_Phillarmonic_FrankenZstd_compressAsync, arginfo_Phillarmonic_FrankenZstd_compressAsync, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "decompressAsync"), zif_Phillarmonic_FrankenZstd_decompressAsync, arginfo_Phillarmonic_FrankenZstd_decompressAsync, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "ob_handler"), zif_Phillarmonic_FrankenZstd_ob_handler, arginfo_Phillarmonic_FrankenZstd_ob_handler, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "compressSeekable"), zif_Phillarmonic_FrankenZstd_compressSeekable, arginfo_Phillarmonic_FrankenZstd_compressSeekable, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "decompressRange"), zif_Phillarmonic_FrankenZstd_decompressRange, arginfo_Phillarmonic_FrankenZstd_decompressRange, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "trainDictionary"), zif_Phillarmonic_FrankenZstd_trainDictionary, arginfo_Phillarmonic_FrankenZstd_trainDictionary, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "registerDictionary"), zif_Phillarmonic_FrankenZstd_registerDictionary, arginfo_Phillarmonic_FrankenZstd_registerDictionary, 0, NULL, NULL)
 	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "getInfo"), zif_Phillarmonic_FrankenZstd_getInfo, arginfo_Phillarmonic_FrankenZstd_getInfo, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "getMetrics"), zif_Phillarmonic_FrankenZstd_getMetrics, arginfo_Phillarmonic_FrankenZstd_getMetrics, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "getMemoryUsage"), zif_Phillarmonic_FrankenZstd_getMemoryUsage, arginfo_Phillarmonic_FrankenZstd_getMemoryUsage, 0, NULL, NULL)
+	ZEND_RAW_FENTRY(ZEND_NS_NAME("Phillarmonic\\FrankenZstd", "getCacheStats"), zif_Phillarmonic_FrankenZstd_getCacheStats, arginfo_Phillarmonic_FrankenZstd_getCacheStats, 0, NULL, NULL)
 	ZEND_FE_END
 };
 
 static const zend_function_entry class_Phillarmonic_FrankenZstd_Compressor_methods[] = {
 	ZEND_ME(Phillarmonic_FrankenZstd_Compressor, create, arginfo_class_Phillarmonic_FrankenZstd_Compressor_create, ZEND_ACC_PUBLIC|ZEND_ACC_STATIC)
+	ZEND_ME(Phillarmonic_FrankenZstd_Compressor, persistent, arginfo_class_Phillarmonic_FrankenZstd_Compressor_persistent, ZEND_ACC_PUBLIC|ZEND_ACC_STATIC)
+	ZEND_ME(Phillarmonic_FrankenZstd_Compressor, adaptive, arginfo_class_Phillarmonic_FrankenZstd_Compressor_adaptive, ZEND_ACC_PUBLIC|ZEND_ACC_STATIC)
 	ZEND_ME(Phillarmonic_FrankenZstd_Compressor, compress, arginfo_class_Phillarmonic_FrankenZstd_Compressor_compress, ZEND_ACC_PUBLIC)
 	ZEND_ME(Phillarmonic_FrankenZstd_Compressor, decompress, arginfo_class_Phillarmonic_FrankenZstd_Compressor_decompress, ZEND_ACC_PUBLIC)
+	ZEND_ME(Phillarmonic_FrankenZstd_Compressor, compressMany, arginfo_class_Phillarmonic_FrankenZstd_Compressor_compressMany, ZEND_ACC_PUBLIC)
+	ZEND_ME(Phillarmonic_FrankenZstd_Compressor, decompressMany, arginfo_class_Phillarmonic_FrankenZstd_Compressor_decompressMany, ZEND_ACC_PUBLIC)
 	ZEND_ME(Phillarmonic_FrankenZstd_Compressor, getStats, arginfo_class_Phillarmonic_FrankenZstd_Compressor_getStats, ZEND_ACC_PUBLIC)
 	ZEND_ME(Phillarmonic_FrankenZstd_Compressor, close, arginfo_class_Phillarmonic_FrankenZstd_Compressor_close, ZEND_ACC_PUBLIC)
 	ZEND_FE_END
@@ -66,6 +265,31 @@ static const zend_function_entry class_Phillarmonic_FrankenZstd_CompressionExcep
 	ZEND_FE_END
 };
 
+static const zend_function_entry class_Phillarmonic_FrankenZstd_StreamCompressor_methods[] = {
+	ZEND_ME(Phillarmonic_FrankenZstd_StreamCompressor, create, arginfo_class_Phillarmonic_FrankenZstd_StreamCompressor_create, ZEND_ACC_PUBLIC|ZEND_ACC_STATIC)
+	ZEND_ME(Phillarmonic_FrankenZstd_StreamCompressor, write, arginfo_class_Phillarmonic_FrankenZstd_StreamCompressor_write, ZEND_ACC_PUBLIC)
+	ZEND_ME(Phillarmonic_FrankenZstd_StreamCompressor, flush, arginfo_class_Phillarmonic_FrankenZstd_StreamCompressor_flush, ZEND_ACC_PUBLIC)
+	ZEND_ME(Phillarmonic_FrankenZstd_StreamCompressor, finish, arginfo_class_Phillarmonic_FrankenZstd_StreamCompressor_finish, ZEND_ACC_PUBLIC)
+	ZEND_ME(Phillarmonic_FrankenZstd_StreamCompressor, close, arginfo_class_Phillarmonic_FrankenZstd_StreamCompressor_close, ZEND_ACC_PUBLIC)
+	ZEND_FE_END
+};
+
+static const zend_function_entry class_Phillarmonic_FrankenZstd_StreamDecompressor_methods[] = {
+	ZEND_ME(Phillarmonic_FrankenZstd_StreamDecompressor, create, arginfo_class_Phillarmonic_FrankenZstd_StreamDecompressor_create, ZEND_ACC_PUBLIC|ZEND_ACC_STATIC)
+	ZEND_ME(Phillarmonic_FrankenZstd_StreamDecompressor, write, arginfo_class_Phillarmonic_FrankenZstd_StreamDecompressor_write, ZEND_ACC_PUBLIC)
+	ZEND_ME(Phillarmonic_FrankenZstd_StreamDecompressor, read, arginfo_class_Phillarmonic_FrankenZstd_StreamDecompressor_read, ZEND_ACC_PUBLIC)
+	ZEND_ME(Phillarmonic_FrankenZstd_StreamDecompressor, finish, arginfo_class_Phillarmonic_FrankenZstd_StreamDecompressor_finish, ZEND_ACC_PUBLIC)
+	ZEND_ME(Phillarmonic_FrankenZstd_StreamDecompressor, close, arginfo_class_Phillarmonic_FrankenZstd_StreamDecompressor_close, ZEND_ACC_PUBLIC)
+	ZEND_FE_END
+};
+
+static const zend_function_entry class_Phillarmonic_FrankenZstd_Future_methods[] = {
+	ZEND_ME(Phillarmonic_FrankenZstd_Future, wait, arginfo_class_Phillarmonic_FrankenZstd_Future_wait, ZEND_ACC_PUBLIC)
+	ZEND_ME(Phillarmonic_FrankenZstd_Future, isReady, arginfo_class_Phillarmonic_FrankenZstd_Future_isReady, ZEND_ACC_PUBLIC)
+	ZEND_ME(Phillarmonic_FrankenZstd_Future, waitAll, arginfo_class_Phillarmonic_FrankenZstd_Future_waitAll, ZEND_ACC_PUBLIC|ZEND_ACC_STATIC)
+	ZEND_FE_END
+};
+
 static zend_class_entry *register_class_Phillarmonic_FrankenZstd_Compressor(void)
 {
 	zend_class_entry ce, *class_entry;
@@ -133,6 +357,24 @@ static zend_class_entry *register_class_Phillarmonic_FrankenZstd_Compressor(void
 	zend_declare_typed_property(class_entry, property_windowSize_name, &property_windowSize_default_value, ZEND_ACC_PUBLIC|ZEND_ACC_READONLY, NULL, (zend_type) ZEND_TYPE_INIT_MASK(MAY_BE_LONG));
 	zend_string_release(property_windowSize_name);
 
+	zval property_dictId_default_value;
+	ZVAL_UNDEF(&property_dictId_default_value);
+	zend_string *property_dictId_name = zend_string_init("dictId", sizeof("dictId") - 1, 1);
+	zend_declare_typed_property(class_entry, property_dictId_name, &property_dictId_default_value, ZEND_ACC_PUBLIC|ZEND_ACC_READONLY, NULL, (zend_type) ZEND_TYPE_INIT_MASK(MAY_BE_LONG));
+	zend_string_release(property_dictId_name);
+
+	zval property_threads_default_value;
+	ZVAL_UNDEF(&property_threads_default_value);
+	zend_string *property_threads_name = zend_string_init("threads", sizeof("threads") - 1, 1);
+	zend_declare_typed_property(class_entry, property_threads_name, &property_threads_default_value, ZEND_ACC_PUBLIC|ZEND_ACC_READONLY, NULL, (zend_type) ZEND_TYPE_INIT_MASK(MAY_BE_LONG));
+	zend_string_release(property_threads_name);
+
+	zval property_persistent_default_value;
+	ZVAL_UNDEF(&property_persistent_default_value);
+	zend_string *property_persistent_name = zend_string_init("persistent", sizeof("persistent") - 1, 1);
+	zend_declare_typed_property(class_entry, property_persistent_name, &property_persistent_default_value, ZEND_ACC_PUBLIC|ZEND_ACC_READONLY, NULL, (zend_type) ZEND_TYPE_INIT_MASK(MAY_BE_BOOL));
+	zend_string_release(property_persistent_name);
+
 	return class_entry;
 }
 
@@ -145,3 +387,33 @@ static zend_class_entry *register_class_Phillarmonic_FrankenZstd_CompressionExce
 
 	return class_entry;
 }
+
+static zend_class_entry *register_class_Phillarmonic_FrankenZstd_StreamCompressor(void)
+{
+	zend_class_entry ce, *class_entry;
+
+	INIT_NS_CLASS_ENTRY(ce, "Phillarmonic\\FrankenZstd", "StreamCompressor", class_Phillarmonic_FrankenZstd_StreamCompressor_methods);
+	class_entry = zend_register_internal_class_with_flags(&ce, NULL, ZEND_ACC_FINAL);
+
+	return class_entry;
+}
+
+static zend_class_entry *register_class_Phillarmonic_FrankenZstd_StreamDecompressor(void)
+{
+	zend_class_entry ce, *class_entry;
+
+	INIT_NS_CLASS_ENTRY(ce, "Phillarmonic\\FrankenZstd", "StreamDecompressor", class_Phillarmonic_FrankenZstd_StreamDecompressor_methods);
+	class_entry = zend_register_internal_class_with_flags(&ce, NULL, ZEND_ACC_FINAL);
+
+	return class_entry;
+}
+
+static zend_class_entry *register_class_Phillarmonic_FrankenZstd_Future(void)
+{
+	zend_class_entry ce, *class_entry;
+
+	INIT_NS_CLASS_ENTRY(ce, "Phillarmonic\\FrankenZstd", "Future", class_Phillarmonic_FrankenZstd_Future_methods);
+	class_entry = zend_register_internal_class_with_flags(&ce, NULL, ZEND_ACC_FINAL);
+
+	return class_entry;
+}
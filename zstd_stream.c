@@ -0,0 +1,349 @@
+#include <php.h>
+#include <ext/standard/file.h>
+#include "zstd.h"
+
+// Contains symbols exported by Go
+#include "_cgo_export.h"
+
+#define ZSTD_WRAPPER_PREFIX "compress.zstd://"
+
+// State of a zstd.compress or zstd.decompress filter: the handle of the Go
+// stream it feeds, bucket by bucket, and for decompression the output
+// produced so far against its limit (0 for none)
+typedef struct {
+    uint64_t handle;
+    zend_long max_output;
+    zend_long produced;
+    bool compress;
+    bool finished;
+    bool persistent;
+} zstd_filter_data;
+
+// Appends an output produced by Go to the outgoing brigade. Go parks stream
+// output behind a handle, which is copied once into the bucket buffer.
+static bool zstd_filter_emit(php_stream *stream, zstd_filter_data *data, php_stream_bucket_brigade *buckets_out, size_t out_len, uintptr_t pending)
+{
+    if (out_len == 0) {
+        return false;
+    }
+
+    char *buf = pemalloc(out_len, data->persistent);
+    go_result_take(pending, buf);
+    php_stream_bucket_append(buckets_out, php_stream_bucket_new(stream, buf, out_len, 1, data->persistent));
+    return true;
+}
+
+// Output a decompressing filter asks of its stream per call into Go: one
+// stream chunk, or one byte past what is left of the limit, which tells an
+// output of exactly max_output bytes from a larger one
+static zend_long zstd_filter_cap(php_stream *stream, zstd_filter_data *data)
+{
+    zend_long cap = stream->chunk_size > 0 ? (zend_long) stream->chunk_size : 8192;
+    if (data->max_output > 0) {
+        cap = MIN(cap, data->max_output - data->produced + 1);
+    }
+    return cap;
+}
+
+// Drains the output a decompressing filter has left in the decoder, one
+// bucket of at most a chunk at a time, so a highly compressible bucket is
+// never decoded whole into a single buffer. The first call, a write or the
+// finish of the stream, was already made by the caller.
+static bool zstd_filter_drain(php_stream *stream, zstd_filter_data *data, php_stream_bucket_brigade *buckets_out, size_t out_len, uintptr_t pending, bool *emitted, char **error)
+{
+    while (out_len > 0) {
+        data->produced += (zend_long) out_len;
+        *emitted |= zstd_filter_emit(stream, data, buckets_out, out_len, pending);
+        if (data->max_output > 0 && data->produced > data->max_output) {
+            char message[80];
+            snprintf(message, sizeof(message), "decompressed size exceeds the limit of " ZEND_LONG_FMT " bytes", data->max_output);
+            *error = strdup(message);
+            return false;
+        }
+
+        out_len = 0;
+        pending = 0;
+        go_stream_decompressor_read(data->handle, zstd_filter_cap(stream, data), &out_len, &pending, error);
+        if (*error) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static php_stream_filter_status_t zstd_filter(
+    php_stream *stream,
+    php_stream_filter *thisfilter,
+    php_stream_bucket_brigade *buckets_in,
+    php_stream_bucket_brigade *buckets_out,
+    size_t *bytes_consumed,
+    int flags)
+{
+    zstd_filter_data *data = Z_PTR(thisfilter->abstract);
+    size_t consumed = 0;
+    bool emitted = false;
+    size_t out_len;
+    uintptr_t pending;
+    char *error = NULL;
+
+    while (buckets_in->head) {
+        php_stream_bucket *bucket = buckets_in->head;
+        php_stream_bucket_unlink(bucket);
+
+        out_len = 0;
+        pending = 0;
+        if (data->finished) {
+            error = strdup("stream already finished");
+        } else if (data->compress) {
+            go_stream_compressor_write(data->handle, bucket->buf, bucket->buflen, &out_len, &pending, &error);
+        } else {
+            go_stream_decompressor_write(data->handle, bucket->buf, bucket->buflen, zstd_filter_cap(stream, data), &out_len, &pending, &error);
+        }
+        consumed += bucket->buflen;
+        php_stream_bucket_delref(bucket);
+
+        if (error) {
+            goto fail;
+        }
+        if (data->compress) {
+            emitted |= zstd_filter_emit(stream, data, buckets_out, out_len, pending);
+        } else if (!zstd_filter_drain(stream, data, buckets_out, out_len, pending, &emitted, &error)) {
+            goto fail;
+        }
+    }
+
+    if (!data->finished && (flags & PSFS_FLAG_FLUSH_CLOSE)) {
+        // End the frame, or check that the input ended on a frame boundary
+        out_len = 0;
+        pending = 0;
+        data->finished = true;
+        if (data->compress) {
+            go_stream_compressor_finish(data->handle, &out_len, &pending, &error);
+        } else {
+            go_stream_decompressor_finish(data->handle, zstd_filter_cap(stream, data), &out_len, &pending, &error);
+        }
+        if (error) {
+            goto fail;
+        }
+        if (data->compress) {
+            emitted |= zstd_filter_emit(stream, data, buckets_out, out_len, pending);
+        } else if (!zstd_filter_drain(stream, data, buckets_out, out_len, pending, &emitted, &error)) {
+            goto fail;
+        }
+    } else if (!data->finished && data->compress && (flags & PSFS_FLAG_FLUSH_INC)) {
+        // fflush() ends the current block so the reader can decode it
+        out_len = 0;
+        pending = 0;
+        go_stream_compressor_flush(data->handle, &out_len, &pending, &error);
+        if (error) {
+            goto fail;
+        }
+        emitted |= zstd_filter_emit(stream, data, buckets_out, out_len, pending);
+    }
+
+    if (bytes_consumed) {
+        *bytes_consumed = consumed;
+    }
+
+    return emitted ? PSFS_PASS_ON : PSFS_FEED_ME;
+
+fail:
+    php_error_docref(NULL, E_WARNING, "%s failed: %s", data->compress ? "Compression" : "Decompression", error);
+    free(error);
+    return PSFS_ERR_FATAL;
+}
+
+static void zstd_filter_dtor(php_stream_filter *thisfilter)
+{
+    zstd_filter_data *data = Z_PTR(thisfilter->abstract);
+    if (!data) {
+        return;
+    }
+
+    char *error = data->compress
+        ? go_stream_compressor_close(data->handle)
+        : go_stream_decompressor_close(data->handle);
+    if (error) free(error);
+
+    pefree(data, data->persistent);
+}
+
+static const php_stream_filter_ops zstd_compress_filter_ops = {
+    zstd_filter,
+    zstd_filter_dtor,
+    "zstd.compress"
+};
+
+static const php_stream_filter_ops zstd_decompress_filter_ops = {
+    zstd_filter,
+    zstd_filter_dtor,
+    "zstd.decompress"
+};
+
+// Reads an integer filter parameter from an options array
+static void zstd_filter_param(zval *params, const char *name, zend_long *value)
+{
+    zval *zv = zend_hash_str_find_deref(Z_ARRVAL_P(params), name, strlen(name));
+    if (zv) {
+        *value = zval_get_long(zv);
+    }
+}
+
+// Filter factory for zstd.compress and zstd.decompress. The parameters are
+// either a compression level or an array of level, windowSize and dictId
+// (maxWindowSize and maxOutput when decompressing), with the defaults of the
+// stream classes.
+static php_stream_filter *zstd_filter_create(const char *filtername, zval *filterparams, bool persistent)
+{
+    const php_stream_filter_ops *ops;
+    zend_long level = 3;
+    zend_long window_size = 22;
+    zend_long dict_id = 0;
+    zend_long max_window_size = 27;
+    zend_long max_output = 0;
+
+    if (strcasecmp(filtername, "zstd.compress") == 0) {
+        ops = &zstd_compress_filter_ops;
+    } else if (strcasecmp(filtername, "zstd.decompress") == 0) {
+        ops = &zstd_decompress_filter_ops;
+    } else {
+        return NULL;
+    }
+
+    if (filterparams) {
+        ZVAL_DEREF(filterparams);
+        if (Z_TYPE_P(filterparams) == IS_ARRAY) {
+            zstd_filter_param(filterparams, "level", &level);
+            zstd_filter_param(filterparams, "windowSize", &window_size);
+            zstd_filter_param(filterparams, "dictId", &dict_id);
+            zstd_filter_param(filterparams, "maxWindowSize", &max_window_size);
+            zstd_filter_param(filterparams, "maxOutput", &max_output);
+        } else if (Z_TYPE_P(filterparams) != IS_NULL) {
+            level = zval_get_long(filterparams);
+        }
+    }
+
+    if (dict_id < 0 || dict_id > (zend_long)UINT32_MAX) {
+        php_error_docref(NULL, E_WARNING, "Invalid dictionary ID: " ZEND_LONG_FMT " (must be 0-4294967295)", dict_id);
+        return NULL;
+    }
+
+    if (max_output < 0) {
+        php_error_docref(NULL, E_WARNING, "Invalid maximum output size: " ZEND_LONG_FMT " (must be 0 or more)", max_output);
+        return NULL;
+    }
+
+    zstd_filter_data *data = pecalloc(1, sizeof(zstd_filter_data), persistent);
+    data->max_output = max_output;
+    data->compress = ops == &zstd_compress_filter_ops;
+    data->persistent = persistent;
+
+    char *error = data->compress
+        ? go_stream_compressor_create(level, window_size, dict_id, &data->handle)
+        : go_stream_decompressor_create(max_window_size, &data->handle);
+    if (error) {
+        php_error_docref(NULL, E_WARNING, "Failed to create %s filter: %s", filtername, error);
+        free(error);
+        pefree(data, persistent);
+        return NULL;
+    }
+
+    return php_stream_filter_alloc(ops, data, persistent);
+}
+
+static const php_stream_filter_factory zstd_filter_factory = {
+    zstd_filter_create
+};
+
+// Strips the compress.zstd:// prefix from a wrapper path
+static const char *zstd_wrapper_path(const char *path)
+{
+    if (strncasecmp(path, ZSTD_WRAPPER_PREFIX, sizeof(ZSTD_WRAPPER_PREFIX) - 1) == 0) {
+        return path + sizeof(ZSTD_WRAPPER_PREFIX) - 1;
+    }
+    return path;
+}
+
+// Opens compress.zstd://<path> by opening <path> with its own wrapper and
+// stacking a zstd filter on it: decompress on the read chain for 'r' modes,
+// compress on the write chain otherwise. Options for the filter are taken
+// from the "zstd" entry of the stream context.
+static php_stream *zstd_wrapper_open(
+    php_stream_wrapper *wrapper,
+    const char *path,
+    const char *mode,
+    int options,
+    zend_string **opened_path,
+    php_stream_context *context STREAMS_DC)
+{
+    if (strchr(mode, '+')) {
+        php_stream_wrapper_log_error(wrapper, options, "Cannot open a zstd stream for reading and writing at the same time");
+        return NULL;
+    }
+
+    php_stream *stream = php_stream_open_wrapper_ex(zstd_wrapper_path(path), mode, options | REPORT_ERRORS, opened_path, context);
+    if (!stream) {
+        return NULL;
+    }
+
+    zval *params = NULL;
+    if (context) {
+        params = zend_hash_str_find_deref(Z_ARRVAL(context->options), "zstd", sizeof("zstd") - 1);
+    }
+
+    bool reading = mode[0] == 'r';
+    php_stream_filter *filter = zstd_filter_create(reading ? "zstd.decompress" : "zstd.compress", params, php_stream_is_persistent(stream));
+    if (!filter) {
+        php_stream_close(stream);
+        return NULL;
+    }
+
+    php_stream_filter_append(reading ? &stream->readfilters : &stream->writefilters, filter);
+    return stream;
+}
+
+// stat() on a compress.zstd:// URL reports the compressed file
+static int zstd_wrapper_url_stat(php_stream_wrapper *wrapper, const char *url, int flags, php_stream_statbuf *ssb, php_stream_context *context)
+{
+    const char *path = zstd_wrapper_path(url);
+    php_stream_wrapper *inner = php_stream_locate_url_wrapper(path, &path, 0);
+    if (!inner || !inner->wops->url_stat) {
+        return -1;
+    }
+    return inner->wops->url_stat(inner, path, flags, ssb, context);
+}
+
+static const php_stream_wrapper_ops zstd_wrapper_ops = {
+    zstd_wrapper_open,
+    NULL, // close
+    NULL, // stat
+    zstd_wrapper_url_stat,
+    NULL, // opendir
+    "ZSTD",
+    NULL, // unlink
+    NULL, // rename
+    NULL, // mkdir
+    NULL, // rmdir
+    NULL  // metadata
+};
+
+static const php_stream_wrapper zstd_wrapper = {
+    &zstd_wrapper_ops,
+    NULL,
+    0 // is_url
+};
+
+PHP_MINIT_FUNCTION(zstd_stream)
+{
+    if (php_stream_filter_register_factory("zstd.*", &zstd_filter_factory) == FAILURE) {
+        return FAILURE;
+    }
+    return php_register_url_stream_wrapper("compress.zstd", &zstd_wrapper);
+}
+
+PHP_MSHUTDOWN_FUNCTION(zstd_stream)
+{
+    php_unregister_url_stream_wrapper("compress.zstd");
+    php_stream_filter_unregister_factory("zstd.*");
+    return SUCCESS;
+}